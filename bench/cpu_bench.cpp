@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "cpu.h"
+#include "trace.h"
+
+// Microbenchmarks for the CPU hot paths. Prints JSON by default so runs can
+// be kept and compared across commits; pass --benchmark_format=console for a
+// table or --benchmark_out=FILE to write the JSON to a file.
+
+// Program in RAM exercising the addressing modes, operands point at zero page
+// $10, which holds the pointer $0300 for the indirect modes.
+const uint16_t PROGRAM = 0x0200;
+const uint8_t PROGRAM_CODE[] = {
+    0xA9, 0x42,       // LDA #$42
+    0xA5, 0x10,       // LDA $10
+    0xB5, 0x10,       // LDA $10,X
+    0x96, 0x10,       // STX $10,Y
+    0xAD, 0x00, 0x03, // LDA $0300
+    0xBD, 0x00, 0x03, // LDA $0300,X
+    0xB9, 0x00, 0x03, // LDA $0300,Y
+    0xA1, 0x10,       // LDA ($10,X)
+    0xB1, 0x10,       // LDA ($10),Y
+    0xEA,             // NOP
+};
+
+// CPU over a 32KB ROM of NOPs with PROGRAM_CODE copied into RAM.
+CPU make_cpu()
+{
+    std::vector<uint8_t> raw(NES_HEADER_SIZE + PRG_ROM_PAGE_SIZE * 2, 0xEA);
+    std::fill(raw.begin(), raw.begin() + NES_HEADER_SIZE, 0);
+    std::copy(std::begin(NES_TAG), std::end(NES_TAG), raw.begin());
+    raw[4] = 2;
+    CPU cpu{Bus(Rom(std::move(raw)))};
+    cpu.reset();
+    for (uint16_t i = 0; i < 0x800; ++i)
+    {
+        cpu.mem_write(i, static_cast<uint8_t>(i));
+    }
+    cpu.mem_write_u16(0x10, 0x0300);
+    for (size_t i = 0; i < sizeof(PROGRAM_CODE); ++i)
+    {
+        cpu.mem_write(PROGRAM + i, PROGRAM_CODE[i]);
+    }
+    cpu.register_x = 0x00;
+    cpu.register_y = 0x04;
+    cpu.pc = PROGRAM;
+    return cpu;
+}
+
+// Fetch the opcode byte and look up its table entry, walking the program.
+void BM_FetchDecode(benchmark::State &state)
+{
+    CPU cpu = make_cpu();
+    for (auto _ : state)
+    {
+        const OpCode &op = OP_CODES[cpu.mem_read(cpu.pc)];
+        benchmark::DoNotOptimize(op.mode);
+        cpu.pc += op.len;
+        if (cpu.pc >= PROGRAM + sizeof(PROGRAM_CODE))
+        {
+            cpu.pc = PROGRAM;
+        }
+    }
+}
+BENCHMARK(BM_FetchDecode);
+
+// Operand byte offset of each mode inside PROGRAM_CODE.
+template <AddressingMode mode>
+constexpr uint16_t operand_offset()
+{
+    switch (mode)
+    {
+    case AddressingMode::Immediate:
+        return 1;
+    case AddressingMode::ZeroPage:
+        return 3;
+    case AddressingMode::ZeroPageX:
+        return 5;
+    case AddressingMode::ZeroPageY:
+        return 7;
+    case AddressingMode::Absolute:
+        return 9;
+    case AddressingMode::AbsoluteX:
+        return 12;
+    case AddressingMode::AbsoluteY:
+        return 15;
+    case AddressingMode::IndirectX:
+        return 18;
+    default:
+        return 20;
+    }
+}
+
+template <AddressingMode mode>
+void BM_GetOperandAddress(benchmark::State &state)
+{
+    CPU cpu = make_cpu();
+    cpu.pc = PROGRAM + operand_offset<mode>();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(cpu.get_operand_address<mode>());
+    }
+}
+BENCHMARK_TEMPLATE(BM_GetOperandAddress, AddressingMode::Immediate);
+BENCHMARK_TEMPLATE(BM_GetOperandAddress, AddressingMode::ZeroPage);
+BENCHMARK_TEMPLATE(BM_GetOperandAddress, AddressingMode::ZeroPageX);
+BENCHMARK_TEMPLATE(BM_GetOperandAddress, AddressingMode::ZeroPageY);
+BENCHMARK_TEMPLATE(BM_GetOperandAddress, AddressingMode::Absolute);
+BENCHMARK_TEMPLATE(BM_GetOperandAddress, AddressingMode::AbsoluteX);
+BENCHMARK_TEMPLATE(BM_GetOperandAddress, AddressingMode::AbsoluteY);
+BENCHMARK_TEMPLATE(BM_GetOperandAddress, AddressingMode::IndirectX);
+BENCHMARK_TEMPLATE(BM_GetOperandAddress, AddressingMode::IndirectY);
+
+// Runtime-mode variant used by the tracer.
+template <AddressingMode mode>
+void BM_GetAbsAddress(benchmark::State &state)
+{
+    CPU cpu = make_cpu();
+    uint16_t begin = PROGRAM + operand_offset<mode>();
+    AddressingMode runtime_mode = mode;
+    benchmark::DoNotOptimize(runtime_mode);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(cpu.get_abs_address(runtime_mode, begin));
+    }
+}
+BENCHMARK_TEMPLATE(BM_GetAbsAddress, AddressingMode::ZeroPage);
+BENCHMARK_TEMPLATE(BM_GetAbsAddress, AddressingMode::ZeroPageX);
+BENCHMARK_TEMPLATE(BM_GetAbsAddress, AddressingMode::Absolute);
+BENCHMARK_TEMPLATE(BM_GetAbsAddress, AddressingMode::AbsoluteX);
+BENCHMARK_TEMPLATE(BM_GetAbsAddress, AddressingMode::IndirectX);
+BENCHMARK_TEMPLATE(BM_GetAbsAddress, AddressingMode::IndirectY);
+
+void BM_AddToRegisterA(benchmark::State &state)
+{
+    CPU cpu = make_cpu();
+    uint8_t value = 0;
+    for (auto _ : state)
+    {
+        cpu.add_to_register_a(value++);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_AddToRegisterA);
+
+void BM_SetZeroAndNegativeFlags(benchmark::State &state)
+{
+    CPU cpu = make_cpu();
+    uint8_t value = 0;
+    for (auto _ : state)
+    {
+        cpu.set_zero_and_negative_flags(value++);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_SetZeroAndNegativeFlags);
+
+// One push and one pop per iteration so the stack pointer stays put.
+void BM_StackPushPop(benchmark::State &state)
+{
+    CPU cpu = make_cpu();
+    uint8_t value = 0;
+    for (auto _ : state)
+    {
+        cpu.stack_push(value++);
+        benchmark::DoNotOptimize(cpu.stack_pop());
+    }
+}
+BENCHMARK(BM_StackPushPop);
+
+void BM_StackPushPopU16(benchmark::State &state)
+{
+    CPU cpu = make_cpu();
+    uint16_t value = 0;
+    for (auto _ : state)
+    {
+        cpu.stack_push_u16(value++);
+        benchmark::DoNotOptimize(cpu.stack_pop_u16());
+    }
+}
+BENCHMARK(BM_StackPushPopU16);
+
+// Reads walking a 2KB window starting at the given address: internal RAM,
+// its mirrors and cartridge ROM.
+void BM_BusMemRead(benchmark::State &state)
+{
+    CPU cpu = make_cpu();
+    uint16_t base = static_cast<uint16_t>(state.range(0));
+    uint16_t offset = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(cpu.bus.mem_read(base + (offset++ & 0x7FF)));
+    }
+}
+BENCHMARK(BM_BusMemRead)->Arg(RAM)->Arg(0x0800)->Arg(PRG_ROM)->Arg(0xC000);
+
+void BM_BusMemReadU16(benchmark::State &state)
+{
+    CPU cpu = make_cpu();
+    uint16_t base = static_cast<uint16_t>(state.range(0));
+    uint16_t offset = 0;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(cpu.bus.mem_read_u16(base + (offset++ & 0x7FF)));
+    }
+}
+BENCHMARK(BM_BusMemReadU16)->Arg(RAM)->Arg(PRG_ROM);
+
+// Full text trace line per instruction of the program, the old per-line cost.
+void BM_Trace(benchmark::State &state)
+{
+    CPU cpu = make_cpu();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(trace(cpu));
+        cpu.pc += OP_CODES[cpu.mem_read(cpu.pc)].len;
+        if (cpu.pc >= PROGRAM + sizeof(PROGRAM_CODE))
+        {
+            cpu.pc = PROGRAM;
+        }
+    }
+}
+BENCHMARK(BM_Trace);
+
+// Binary record only, what the trace recorders pay per instruction.
+void BM_TraceRecord(benchmark::State &state)
+{
+    CPU cpu = make_cpu();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(trace_record(cpu));
+        cpu.pc += OP_CODES[cpu.mem_read(cpu.pc)].len;
+        if (cpu.pc >= PROGRAM + sizeof(PROGRAM_CODE))
+        {
+            cpu.pc = PROGRAM;
+        }
+    }
+}
+BENCHMARK(BM_TraceRecord);
+
+// One instruction of the program per iteration through each core.
+void BM_Step(benchmark::State &state, bool (CPU::*step)())
+{
+    CPU cpu = make_cpu();
+    for (auto _ : state)
+    {
+        (cpu.*step)();
+        if (cpu.pc >= PROGRAM + sizeof(PROGRAM_CODE) - 1)
+        {
+            cpu.pc = PROGRAM;
+            cpu.register_x = 0x00;
+        }
+    }
+}
+BENCHMARK_CAPTURE(BM_Step, switch, &CPU::step_switch);
+BENCHMARK_CAPTURE(BM_Step, threaded, &CPU::step_threaded);
+
+int main(int argc, char *argv[])
+{
+    // JSON unless the caller picked a format.
+    std::vector<char *> args(argv, argv + argc);
+    std::string json = "--benchmark_format=json";
+    bool has_format = std::any_of(args.begin(), args.end(), [](const char *arg)
+                                  { return std::strncmp(arg, "--benchmark_format", 18) == 0; });
+    if (!has_format)
+    {
+        args.push_back(json.data());
+    }
+    int count = static_cast<int>(args.size());
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data()))
+    {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
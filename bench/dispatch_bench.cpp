@@ -0,0 +1,93 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "cpu.h"
+
+// Compares instructions/second of the switch, threaded and block-cache cores on
+// the official-opcode part of nestest (automation mode, pc = 0xC000).
+
+const std::string FILE_NAME = "../trace/nestest.nes";
+
+// nestest stays on documented opcodes well past this point.
+const int INSTRUCTIONS_PER_RUN = 4000;
+const int RUNS = 2000;
+
+void restart(CPU &cpu)
+{
+    const uint8_t zero[RAM_SIZE] = {};
+    cpu.bus.write_ram(zero);
+    cpu.reset();
+    cpu.pc = 0xc000;
+}
+
+double bench(CPU &cpu, bool (CPU::*step)())
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < RUNS; ++run)
+    {
+        restart(cpu);
+        for (int i = 0; i < INSTRUCTIONS_PER_RUN; ++i)
+        {
+            (cpu.*step)();
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(RUNS) * INSTRUCTIONS_PER_RUN / elapsed.count();
+}
+
+// Same runs through the block loop, the way run_for_* execute with
+// NES_BLOCK_CACHE.
+double bench_blocks(CPU &cpu)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < RUNS; ++run)
+    {
+        restart(cpu);
+        int executed = 0;
+        cpu.run_blocks_until([&](CPU &)
+                             { return executed++ == INSTRUCTIONS_PER_RUN; });
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(RUNS) * INSTRUCTIONS_PER_RUN / elapsed.count();
+}
+
+int main(int argc, char *argv[])
+{
+    CPU cpu{Bus(Rom(std::string(argc > 1 ? argv[1] : FILE_NAME)))};
+
+    // warm up and check both cores agree.
+    bench(cpu, &CPU::step_switch);
+    uint16_t switch_pc = cpu.pc;
+    bench(cpu, &CPU::step_threaded);
+    if (cpu.pc != switch_pc)
+    {
+        std::cerr << "Cores diverged: " << std::hex << switch_pc << " != " << cpu.pc << std::endl;
+        return 1;
+    }
+    bench(cpu, &CPU::step_cached);
+    if (cpu.pc != switch_pc)
+    {
+        std::cerr << "Block cache diverged: " << std::hex << switch_pc << " != " << cpu.pc << std::endl;
+        return 1;
+    }
+    bench_blocks(cpu);
+    if (cpu.pc != switch_pc)
+    {
+        std::cerr << "Block loop diverged: " << std::hex << switch_pc << " != " << cpu.pc << std::endl;
+        return 1;
+    }
+
+    double switch_ips = bench(cpu, &CPU::step_switch);
+    double threaded_ips = bench(cpu, &CPU::step_threaded);
+    double cached_ips = bench(cpu, &CPU::step_cached);
+    double blocks_ips = bench_blocks(cpu);
+
+    std::cout << "switch:   " << switch_ips / 1e6 << " M instructions/s\n";
+    std::cout << "threaded: " << threaded_ips / 1e6 << " M instructions/s\n";
+    std::cout << "cached:   " << cached_ips / 1e6 << " M instructions/s\n";
+    std::cout << "blocks:   " << blocks_ips / 1e6 << " M instructions/s\n";
+    std::cout << "speedup:  " << threaded_ips / switch_ips << "x threaded, " << cached_ips / switch_ips << "x cached, "
+              << blocks_ips / switch_ips << "x blocks\n";
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <chrono>
+#include <iostream>
+#include <malloc.h>
+#include <string>
+#include <vector>
+#include "cpu.h"
+
+// Forks/second and heap bytes per fork of a warm nestest CPU, against full
+// copies. Memory is measured right after forking and again once every child
+// has run a little and dirtied its own pages.
+
+const std::string FILE_NAME = "../trace/nestest.nes";
+
+const size_t FORKS = 20000;
+const int WARM_INSTRUCTIONS = 4000;
+const int CHILD_INSTRUCTIONS = 100;
+
+size_t heap_in_use()
+{
+    return mallinfo2().uordblks;
+}
+
+template <typename F>
+void bench(const char *name, CPU &parent, F &&make_child)
+{
+    // fill once untimed so the vector's pages are already faulted in.
+    std::vector<CPU> children;
+    children.reserve(FORKS);
+    for (size_t i = 0; i < FORKS; ++i)
+    {
+        children.push_back(make_child(parent));
+    }
+    children.clear();
+
+    size_t heap_before = heap_in_use();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < FORKS; ++i)
+    {
+        children.push_back(make_child(parent));
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    size_t heap_forked = heap_in_use();
+
+    for (CPU &child : children)
+    {
+        child.run_for_instructions(CHILD_INSTRUCTIONS);
+    }
+    size_t heap_run = heap_in_use();
+
+    std::cout << name << ":\n";
+    std::cout << "  " << FORKS / elapsed.count() / 1e6 << " M forks/s\n";
+    std::cout << "  " << (heap_forked - heap_before) / FORKS << " heap bytes/fork, "
+              << (heap_run - heap_before) / FORKS << " after " << CHILD_INSTRUCTIONS << " instructions (plus sizeof(CPU))\n";
+}
+
+int main(int argc, char *argv[])
+{
+    CPU parent{Bus(Rom(std::string(argc > 1 ? argv[1] : FILE_NAME)))};
+    parent.reset();
+    parent.pc = 0xc000;
+    parent.run_for_instructions(WARM_INSTRUCTIONS);
+    std::cout << "sizeof(CPU): " << sizeof(CPU) << " bytes\n";
+
+    bench("copy", parent, [](CPU &cpu)
+          { return CPU(cpu); });
+    bench("fork", parent, [](CPU &cpu)
+          { return cpu.fork(); });
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../tests/test.h"
+
+// Compares emulated cycles/second of the interpreter and the JIT tier on
+// hot loops in PRG ROM, and checks both end in the same state.
+
+const uint64_t CYCLES_PER_RUN = 1'000'000;
+const int RUNS = 50;
+
+struct Kernel
+{
+    const char *name;
+    uint16_t pc;
+};
+
+// Only inline ops: the whole loop body runs as native code.
+const std::vector<uint8_t> ARITHMETIC = {
+    0xA2, 0x00,       // 8000: LDX #$00
+    0xA0, 0x00,       // 8002: LDY #$00
+    0x8A,             // 8004: TXA
+    0x18,             // 8005: CLC
+    0x65, 0x10,       // 8006: ADC $10
+    0x85, 0x10,       // 8008: STA $10
+    0x95, 0x20,       // 800A: STA $20,X
+    0xE8,             // 800C: INX
+    0xD0, 0xF5,       // 800D: BNE $8004
+    0xC8,             // 800F: INY
+    0x4C, 0x04, 0x80, // 8010: JMP $8004
+};
+
+// A subroutine call per iteration, JSR/RTS/ROL go through the handlers.
+const std::vector<uint8_t> CALLS = {
+    0xA2, 0x00,       // 8100: LDX #$00
+    0x20, 0x00, 0x82, // 8102: JSR $8200
+    0xE8,             // 8105: INX
+    0xD0, 0xFA,       // 8106: BNE $8102
+    0x4C, 0x02, 0x81, // 8108: JMP $8102
+};
+
+const std::vector<uint8_t> SUBROUTINE = {
+    0xB5, 0x20,       // 8200: LDA $20,X
+    0x2A,             // 8202: ROL A
+    0x45, 0x10,       // 8203: EOR $10
+    0x85, 0x10,       // 8205: STA $10
+    0xAD, 0x00, 0x03, // 8207: LDA $0300
+    0x69, 0x01,       // 820A: ADC #$01
+    0x8D, 0x00, 0x03, // 820C: STA $0300
+    0x60,             // 820F: RTS
+};
+
+const Kernel KERNELS[] = {
+    {"arithmetic", 0x8000},
+    {"calls", 0x8100},
+};
+
+// One 16KB PRG bank mirrored at 0x8000 and 0xC000.
+Rom make_rom()
+{
+    std::vector<uint8_t> raw(NES_HEADER_SIZE + PRG_ROM_PAGE_SIZE + CHR_ROM_PAGE_SIZE, 0);
+    std::memcpy(raw.data(), NES_TAG, sizeof(NES_TAG));
+    raw[4] = 1;
+    raw[5] = 1;
+    uint8_t *prg = raw.data() + NES_HEADER_SIZE;
+    std::memcpy(prg + 0x0000, ARITHMETIC.data(), ARITHMETIC.size());
+    std::memcpy(prg + 0x0100, CALLS.data(), CALLS.size());
+    std::memcpy(prg + 0x0200, SUBROUTINE.data(), SUBROUTINE.size());
+    prg[0x3FFC] = 0x00; // reset vector, 0x8000.
+    prg[0x3FFD] = 0x80;
+    return Rom(raw);
+}
+
+void restart(CPU &cpu, uint16_t pc)
+{
+    const uint8_t zero[RAM_SIZE] = {};
+    cpu.bus.write_ram(zero);
+    cpu.reset();
+    cpu.pc = pc;
+}
+
+double bench(CPU &cpu, uint16_t pc)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < RUNS; ++run)
+    {
+        restart(cpu, pc);
+        cpu.run_for_cycles(CYCLES_PER_RUN);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(RUNS) * CYCLES_PER_RUN / elapsed.count();
+}
+
+int main()
+{
+    CPU interpreter{Bus(make_rom())};
+    CPU jit{Bus(make_rom())};
+    jit.jit_enabled = true;
+
+    for (const Kernel &kernel : KERNELS)
+    {
+        double interpreter_cps = bench(interpreter, kernel.pc);
+        double jit_cps = bench(jit, kernel.pc);
+        if (!same_state(interpreter, jit))
+        {
+            std::cerr << kernel.name << ": JIT diverged, pc " << std::hex << interpreter.pc << " != " << jit.pc
+                      << std::endl;
+            return 1;
+        }
+
+        std::cout << kernel.name << ":\n";
+        std::cout << "  interpreter: " << interpreter_cps / 1e6 << " M cycles/s\n";
+        std::cout << "  jit:         " << jit_cps / 1e6 << " M cycles/s\n";
+        std::cout << "  speedup:     " << jit_cps / interpreter_cps << "x\n";
+    }
+    std::cout << "native instructions: " << jit.jit_instructions << ", code buffer flushes: " << jit.jit_flushes << "\n";
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include "cpu.h"
+
+// mem_read/mem_read_u16 throughput through the statically dispatched
+// CPU -> Bus path versus the same Bus behind the VirtualMem adapter
+// (what every access cost when Mem was a virtual base).
+
+const int ITERATIONS = 50'000'000;
+
+template <typename M>
+uint32_t read_loop(M &mem, uint16_t base, uint16_t mask)
+{
+    uint32_t sum = 0;
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        sum += mem.mem_read(base + (static_cast<uint16_t>(i) & mask));
+    }
+    return sum;
+}
+
+template <typename M>
+uint32_t read_u16_loop(M &mem, uint16_t base, uint16_t mask)
+{
+    uint32_t sum = 0;
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        sum += mem.mem_read_u16(base + (static_cast<uint16_t>(i) & mask));
+    }
+    return sum;
+}
+
+template <typename F>
+void report(const std::string &name, F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    uint32_t sum = f();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << ITERATIONS / elapsed.count() / 1e6 << " M reads/s (checksum " << sum << ")\n";
+}
+
+int main()
+{
+    // 32KB of NOPs behind a minimal iNES header.
+    std::vector<uint8_t> raw(NES_HEADER_SIZE + PRG_ROM_PAGE_SIZE * 2, 0xEA);
+    std::fill(raw.begin(), raw.begin() + NES_HEADER_SIZE, 0);
+    std::copy(std::begin(NES_TAG), std::end(NES_TAG), raw.begin());
+    raw[4] = 2;
+    CPU cpu{Bus(Rom(std::move(raw)))};
+    for (uint16_t i = 0; i < 0x800; ++i)
+    {
+        cpu.mem_write(i, static_cast<uint8_t>(i));
+    }
+
+    MemAdapter<Bus> adapter(cpu.bus);
+    // keep the compiler from devirtualizing the adapter calls.
+    VirtualMem *volatile virtual_mem = &adapter;
+
+    report("static  mem_read     RAM", [&] { return read_loop(cpu, 0x0000, 0x07FF); });
+    report("virtual mem_read     RAM", [&] { return read_loop(*virtual_mem, 0x0000, 0x07FF); });
+    report("static  mem_read     ROM", [&] { return read_loop(cpu, 0x8000, 0x7FFF); });
+    report("virtual mem_read     ROM", [&] { return read_loop(*virtual_mem, 0x8000, 0x7FFF); });
+    report("static  mem_read_u16 RAM", [&] { return read_u16_loop(cpu, 0x0000, 0x07FE); });
+    report("virtual mem_read_u16 RAM", [&] { return read_u16_loop(*virtual_mem, 0x0000, 0x07FE); });
+    report("static  mem_read_u16 ROM", [&] { return read_u16_loop(cpu, 0x8000, 0x7FFE); });
+    report("virtual mem_read_u16 ROM", [&] { return read_u16_loop(*virtual_mem, 0x8000, 0x7FFE); });
+    return 0;
+}
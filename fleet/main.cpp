@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "fleet.h"
+
+// Runs many sessions of one ROM on 1..N worker threads and reports the
+// aggregate instructions/second for each thread count. --jit runs hot ROM
+// blocks of every session as native code (NES_JIT builds).
+//
+// usage: fleet.out [--sessions N] [--cycles N] [--batches N] [--threads N] [--pc ADDR] [--jit] rom.nes
+
+void usage()
+{
+    std::cerr << "usage: fleet.out [--sessions N] [--cycles N] [--batches N] [--threads N] [--pc ADDR] [--jit] rom.nes\n";
+    exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t sessions = 256;
+    uint64_t cycles = 100'000;
+    size_t batches = 10;
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    bool set_pc = false;
+    uint16_t pc = 0;
+    [[maybe_unused]] bool jit = false;
+    std::string file;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg != "--jit" && arg.rfind("--", 0) == 0 && i + 1 >= argc)
+        {
+            usage();
+        }
+
+        if (arg == "--sessions")
+        {
+            sessions = std::stoul(argv[++i], nullptr, 0);
+        }
+        else if (arg == "--cycles")
+        {
+            cycles = std::stoull(argv[++i], nullptr, 0);
+        }
+        else if (arg == "--batches")
+        {
+            batches = std::stoul(argv[++i], nullptr, 0);
+        }
+        else if (arg == "--threads")
+        {
+            max_threads = std::stoul(argv[++i], nullptr, 0);
+        }
+        else if (arg == "--pc")
+        {
+            set_pc = true;
+            pc = static_cast<uint16_t>(std::stoul(argv[++i], nullptr, 0));
+        }
+        else if (arg == "--jit")
+        {
+#ifndef NES_JIT
+            std::cerr << "Built without NES_JIT" << std::endl;
+            exit(1);
+#endif
+            jit = true;
+        }
+        else if (arg.rfind("--", 0) == 0 || !file.empty())
+        {
+            usage();
+        }
+        else
+        {
+            file = arg;
+        }
+    }
+    if (file.empty() || max_threads == 0)
+    {
+        usage();
+    }
+
+    // one copy of the cartridge for every session.
+    auto rom = std::make_shared<const Rom>(file);
+
+    double single_thread_ips = 0;
+    for (size_t threads = 1; threads <= max_threads; ++threads)
+    {
+        Fleet fleet(threads);
+        for (size_t i = 0; i < sessions; ++i)
+        {
+            size_t id = fleet.add(rom);
+            if (set_pc)
+            {
+                fleet.session(id).cpu.pc = pc;
+            }
+#ifdef NES_JIT
+            fleet.session(id).cpu.jit_enabled = jit;
+#endif
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t batch = 0; batch < batches; ++batch)
+        {
+            fleet.run_for_cycles(cycles);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        uint64_t instructions = 0;
+        size_t running = 0;
+        for (size_t id = 0; id < fleet.size(); ++id)
+        {
+            instructions += fleet.session(id).instructions;
+            running += fleet.session(id).running;
+        }
+
+        double ips = instructions / elapsed.count();
+        if (threads == 1)
+        {
+            single_thread_ips = ips;
+        }
+        std::cout << threads << " threads: "
+                  << ips / 1e6 << " M instr/s, "
+                  << ips / single_thread_ips << "x, "
+                  << running << "/" << sessions << " sessions running\n";
+    }
+    return 0;
+}
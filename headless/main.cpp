@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "cpu.h"
+#include "rewind.h"
+
+// Runs each ROM for a fixed budget with nothing in the loop but the CPU,
+// then reports throughput and a hash of the final CPU/RAM state. A save
+// state replaces the boot, the final state can be saved for one ROM. With
+// --rewind, the run also captures into a rewind buffer of that many bytes
+// every --rewind-every instructions/cycles and reports its cost. With
+// --skip-idle, loops waiting on a RAM byte are fast-forwarded (see
+// CPU::skip_idle), --jit runs hot ROM blocks as native code (NES_JIT
+// builds). Either way the results stay the same.
+//
+// usage: headless.out [--cycles N | --instructions N] [--pc ADDR] [--load-state FILE] [--save-state FILE]
+//                     [--rewind BYTES] [--rewind-every N] [--skip-idle] [--jit] rom.nes...
+
+const uint64_t DEFAULT_CYCLES = 10'000'000;
+
+struct Options
+{
+    bool count_cycles = true;
+    uint64_t budget = DEFAULT_CYCLES;
+    bool set_pc = false;
+    uint16_t pc = 0;
+    std::string load_state;
+    std::string save_state;
+    size_t rewind_budget = 0; // 0 = no rewind buffer.
+    uint64_t rewind_every = RewindOptions().interval;
+    bool skip_idle = false;
+    bool jit = false;
+    std::vector<std::string> roms;
+};
+
+void usage()
+{
+    std::cerr << "usage: headless.out [--cycles N | --instructions N] [--pc ADDR] [--load-state FILE] [--save-state FILE]\n"
+              << "                    [--rewind BYTES] [--rewind-every N] [--skip-idle] [--jit] rom.nes...\n";
+    exit(1);
+}
+
+Options parse_args(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if ((arg == "--cycles" || arg == "--instructions" || arg == "--pc" ||
+             arg == "--load-state" || arg == "--save-state" || arg == "--rewind" || arg == "--rewind-every") && i + 1 >= argc)
+        {
+            usage();
+        }
+
+        if (arg == "--cycles")
+        {
+            options.count_cycles = true;
+            options.budget = std::stoull(argv[++i], nullptr, 0);
+        }
+        else if (arg == "--instructions")
+        {
+            options.count_cycles = false;
+            options.budget = std::stoull(argv[++i], nullptr, 0);
+        }
+        else if (arg == "--pc")
+        {
+            options.set_pc = true;
+            options.pc = static_cast<uint16_t>(std::stoul(argv[++i], nullptr, 0));
+        }
+        else if (arg == "--load-state")
+        {
+            options.load_state = argv[++i];
+        }
+        else if (arg == "--save-state")
+        {
+            options.save_state = argv[++i];
+        }
+        else if (arg == "--rewind")
+        {
+            options.rewind_budget = std::stoull(argv[++i], nullptr, 0);
+        }
+        else if (arg == "--rewind-every")
+        {
+            options.rewind_every = std::stoull(argv[++i], nullptr, 0);
+        }
+        else if (arg == "--skip-idle")
+        {
+            options.skip_idle = true;
+        }
+        else if (arg == "--jit")
+        {
+#ifndef NES_JIT
+            std::cerr << "Built without NES_JIT" << std::endl;
+            exit(1);
+#endif
+            options.jit = true;
+        }
+        else if (arg.rfind("--", 0) == 0)
+        {
+            usage();
+        }
+        else
+        {
+            options.roms.push_back(arg);
+        }
+    }
+
+    if (options.roms.empty() || (!options.save_state.empty() && options.roms.size() > 1))
+    {
+        usage();
+    }
+    return options;
+}
+
+// FNV-1a over the registers, cycle count and RAM.
+uint64_t state_hash(const CPU &cpu)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    auto mix = [&hash](uint8_t byte)
+    {
+        hash ^= byte;
+        hash *= 0x100000001b3;
+    };
+
+    mix(cpu.register_a);
+    mix(cpu.register_x);
+    mix(cpu.register_y);
+    mix(cpu.get_status());
+    mix(static_cast<uint8_t>(cpu.pc));
+    mix(static_cast<uint8_t>(cpu.pc >> 8));
+    mix(cpu.stack_pointer);
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        mix(static_cast<uint8_t>(cpu.cycles >> shift));
+    }
+    uint8_t ram[RAM_SIZE];
+    cpu.bus.read_ram(ram);
+    for (uint8_t byte : ram)
+    {
+        mix(byte);
+    }
+    return hash;
+}
+
+int main(int argc, char *argv[])
+{
+    Options options = parse_args(argc, argv);
+
+    uint64_t total_instructions = 0;
+    uint64_t total_cycles = 0;
+    double total_seconds = 0;
+
+    for (const std::string &file : options.roms)
+    {
+        CPU cpu{Bus(Rom(file))};
+        cpu.reset();
+        if (!options.load_state.empty() && !cpu.load_state(read_state(options.load_state)))
+        {
+            std::cerr << options.load_state << " was saved from another ROM than " << file << std::endl;
+            return 1;
+        }
+        if (options.set_pc)
+        {
+            cpu.pc = options.pc;
+        }
+
+        uint64_t start_cycles = cpu.cycles;
+        uint64_t instructions = 0;
+        StopReason stopped = StopReason::Budget;
+
+        std::optional<Rewind> rewind;
+        uint64_t next_capture = 0;
+        if (options.rewind_budget != 0)
+        {
+            RewindOptions rewind_options;
+            rewind_options.budget = options.rewind_budget;
+            rewind_options.interval = options.rewind_every;
+            rewind_options.count_cycles = options.count_cycles;
+            rewind.emplace(rewind_options);
+            next_capture = options.count_cycles ? cpu.cycles : 0;
+        }
+        auto capture = [&]()
+        {
+            uint64_t now = options.count_cycles ? cpu.cycles : instructions;
+            if (rewind && now >= next_capture)
+            {
+                rewind->capture(cpu);
+                next_capture = now + options.rewind_every;
+            }
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        if (options.skip_idle || options.jit)
+        {
+            // The same run through the block loop, in chunks ending where the
+            // loops below would capture.
+            cpu.skip_idle = options.skip_idle;
+#ifdef NES_JIT
+            cpu.jit_enabled = options.jit;
+#endif
+            auto now = [&]()
+            { return options.count_cycles ? cpu.cycles : instructions; };
+            uint64_t end = options.count_cycles ? start_cycles + options.budget : options.budget;
+            while (now() < end)
+            {
+                capture();
+                uint64_t target = rewind ? std::min(end, next_capture) : end;
+                stopped = options.count_cycles ? cpu.run_for_cycles(target - cpu.cycles, instructions)
+                                               : cpu.run_for_instructions(target - instructions, instructions);
+                if (stopped != StopReason::Budget)
+                {
+                    break;
+                }
+            }
+        }
+        else if (options.count_cycles)
+        {
+            uint64_t target = start_cycles + options.budget;
+            while (cpu.cycles < target)
+            {
+                capture();
+                if (!cpu.step())
+                {
+                    stopped = cpu.stop_reason;
+                    break;
+                }
+                instructions++;
+            }
+        }
+        else
+        {
+            while (instructions < options.budget)
+            {
+                capture();
+                if (!cpu.step())
+                {
+                    stopped = cpu.stop_reason;
+                    break;
+                }
+                instructions++;
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        uint64_t cycles = cpu.cycles - start_cycles;
+        total_instructions += instructions;
+        total_cycles += cycles;
+        total_seconds += elapsed.count();
+        if (!options.save_state.empty())
+        {
+            write_state(options.save_state, cpu.save_state());
+        }
+
+        std::cout << file << ": "
+                  << stop_reason_name(stopped) << ", "
+                  << instructions << " instructions, "
+                  << cycles << " cycles, "
+                  << elapsed.count() * 1e3 << " ms, "
+                  << instructions / elapsed.count() / 1e6 << " M instr/s, "
+                  << cycles / elapsed.count() / 1e6 << " M cycles/s, "
+                  << "hash " << std::hex << state_hash(cpu) << std::dec << "\n";
+        if (stopped == StopReason::BusFault)
+        {
+            std::cout << "  write to 0x" << std::hex << cpu.fault_address << ", stopped at pc 0x"
+                      << cpu.pc << std::dec << "\n";
+        }
+        if (options.skip_idle)
+        {
+            std::cout << "  idle: " << cpu.idle_instructions << " of the instructions skipped ("
+                      << (instructions > 0 ? 100.0 * cpu.idle_instructions / instructions : 0) << "%)\n";
+        }
+#ifdef NES_JIT
+        if (options.jit)
+        {
+            std::cout << "  jit: " << cpu.jit_instructions << " of the instructions ran as native code, "
+                      << cpu.jit_flushes << " code buffer flushes\n";
+        }
+#endif
+        if (rewind)
+        {
+            double emulated = cycles / CPU_FREQUENCY;
+            std::cout << "  rewind: " << rewind->captures << " captures, "
+                      << rewind->size() << " held (" << rewind->seconds() << " s), "
+                      << rewind->bytes() << "/" << rewind->budget() << " bytes, "
+                      << rewind->capture_seconds * 1e3 << " ms capturing ("
+                      << 100 * rewind->capture_seconds / elapsed.count() << "% of the run, "
+                      << rewind->capture_seconds / emulated * 1e3 << " ms per emulated second), "
+                      << (rewind->seconds() > 0 ? rewind->bytes() / rewind->seconds() / 1024 : 0) << " KB per emulated second\n";
+        }
+    }
+
+    if (options.roms.size() > 1)
+    {
+        std::cout << "total: "
+                  << total_instructions << " instructions, "
+                  << total_cycles << " cycles, "
+                  << total_seconds * 1e3 << " ms, "
+                  << total_instructions / total_seconds / 1e6 << " M instr/s, "
+                  << total_cycles / total_seconds / 1e6 << " M cycles/s\n";
+    }
+    return 0;
+}
@@ -1,33 +1,18 @@
 #include <iostream>
 #include <cassert>
 #include "cpu.h"
+#include "rewind.h"
 #include <SDL2/SDL.h>
 #include <random>
 #include <chrono>
 #include <thread>
 #include <string>
-#include <fstream>
 #include <cassert>
 
 const std::string FILE_NAME = "../snake/snake.nes";
 
-std::vector<uint8_t> read_rom(const std::string &file)
-{
-    std::ifstream rom_file(file, std::ios::binary);
-
-    if (!rom_file)
-    {
-        std::cerr << "Failed to open file: " << file << std::endl;
-        exit(1);
-    }
-
-    std::vector<uint8_t> rom_data((std::istreambuf_iterator<char>(rom_file)),
-                                  std::istreambuf_iterator<char>());
-
-    rom_file.close();
-
-    return rom_data;
-}
+const uint64_t INSTRUCTIONS_PER_FRAME = 350;
+const std::chrono::microseconds FRAME_TIME(16667); // 60 Hz
 
 SDL_Color color_constructor(uint8_t byte)
 {
@@ -185,11 +170,8 @@ int main()
         return 1;
     }
 
-    std::vector<uint8_t> rom_code = read_rom(FILE_NAME);
-
-    Rom rom(rom_code);
-    Bus bus(rom);
-    CPU cpu(bus);
+    Bus bus(Rom{FILE_NAME});
+    CPU cpu(std::move(bus));
     cpu.reset();
 
     uint8_t screen_state[32 * 3 * 32] = {0};
@@ -198,20 +180,39 @@ int main()
 
     SDL_Event event;
 
-    cpu.run_with_callback([&](CPU &cpu)
-                          {
-                                                    handle_user_input(cpu, event);
+    // captured once per frame, holding Backspace steps back a frame at a time.
+    RewindOptions rewind_options;
+    rewind_options.interval = INSTRUCTIONS_PER_FRAME;
+    Rewind rewind(rewind_options);
 
-                              cpu.mem_write(0xfe, dist(rng));
+    // Input, RNG and the screen are serviced once per frame and the CPU runs
+    // a batch of instructions in between, paced to the old ~20k instr/s.
+    auto next_frame = std::chrono::steady_clock::now();
+    bool running = true;
+    while (running)
+    {
+        handle_user_input(cpu, event);
 
-                              if (read_screen_state(cpu, screen_state)) {
-                                  SDL_UpdateTexture(texture, nullptr, screen_state, 32 * 3);
-                                  SDL_RenderCopy(canvas, texture, nullptr, nullptr);
-                                  SDL_RenderPresent(canvas);
-                              }
+        if (SDL_GetKeyboardState(nullptr)[SDL_SCANCODE_BACKSPACE])
+        {
+            rewind.restore(cpu, rewind.size() > 1 ? 1 : 0);
+        }
+        else
+        {
+            cpu.mem_write(0xfe, dist(rng));
+            running = rewind.run(cpu, INSTRUCTIONS_PER_FRAME) == StopReason::Budget;
+        }
 
-                              std::this_thread::sleep_for(std::chrono::microseconds(50));
-                          });
+        if (read_screen_state(cpu, screen_state))
+        {
+            SDL_UpdateTexture(texture, nullptr, screen_state, 32 * 3);
+            SDL_RenderCopy(canvas, texture, nullptr, nullptr);
+            SDL_RenderPresent(canvas);
+        }
+
+        next_frame += FRAME_TIME;
+        std::this_thread::sleep_until(next_frame);
+    }
 
     // Clean up
     SDL_DestroyTexture(texture);
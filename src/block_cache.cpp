@@ -0,0 +1,54 @@
+#include "block_cache.h"
+#include <algorithm>
+#include <iterator>
+
+BlockCache::Block &BlockCache::insert(uint16_t start, uint32_t first, uint8_t count, uint16_t prefix_cycles)
+{
+    uint16_t &table = this->pages[start >> 8];
+    if (table == 0)
+    {
+        this->entries.resize(this->entries.size() + 256, 0);
+        table = static_cast<uint16_t>(this->entries.size() / 256);
+    }
+    this->blocks.push_back(Block{first, start, count, prefix_cycles, 0, nullptr, false});
+    this->entries[(table - 1) * 256 + (start & 0xFF)] = static_cast<uint32_t>(this->blocks.size());
+
+    if (start < 0x2000)
+    {
+        // mark every RAM page the block's bytes touch.
+        uint32_t end = start;
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+            end += this->ops[i].len;
+        }
+        for (uint32_t address = start & 0xFF00; address < end; address += 0x100)
+        {
+            this->code_pages[(address & 0x7FF) >> 8] = 1;
+        }
+    }
+    return this->blocks.back();
+}
+
+// Forgets every block that starts in RAM, including mirrors. Their ops stay
+// in the pool until the next clear().
+void BlockCache::invalidate_ram()
+{
+    for (size_t page = 0; page < 0x20; ++page)
+    {
+        if (this->pages[page] != 0)
+        {
+            auto table = this->entries.begin() + (this->pages[page] - 1) * 256;
+            std::fill(table, table + 256, 0);
+        }
+    }
+    std::fill(std::begin(this->code_pages), std::end(this->code_pages), 0);
+}
+
+void BlockCache::clear()
+{
+    this->blocks.clear();
+    this->ops.clear();
+    this->entries.clear();
+    std::fill(std::begin(this->pages), std::end(this->pages), 0);
+    std::fill(std::begin(this->code_pages), std::end(this->code_pages), 0);
+}
@@ -0,0 +1,84 @@
+#ifndef BLOCK_CACHE_H
+#define BLOCK_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct CPU;
+// Runs one instruction, pc already points past the opcode byte.
+using OpHandler = bool (*)(CPU &);
+// A whole block translated to native code by the JIT tier (NES_JIT).
+using NativeBlock = void (*)(CPU *);
+
+// One predecoded instruction of a block.
+struct DecodedOp
+{
+    OpHandler handler;
+    uint8_t opcode;
+    uint8_t len;
+    // Set when this op starts a run of FUSED_OPS (ROM blocks only): `fused`
+    // executes all fused_count instructions, the ones before the last take
+    // at most fused_prefix_cycles. The run's later ops stay in the block for
+    // when the run can't be taken as a whole.
+    uint8_t fused_count = 0;
+    uint8_t fused_prefix_cycles = 0;
+    OpHandler fused = nullptr;
+};
+
+// Predecoded straight-line runs of instructions keyed by their start pc,
+// each ends at the first branch/jump. Blocks decoded from RAM are dropped
+// when a write hits one of their pages; ROM blocks live until clear().
+struct BlockCache
+{
+    static constexpr size_t MAX_BLOCK_OPS = 32;
+    static constexpr size_t MAX_OPS = 1 << 16; // pool size before everything is dropped.
+    static constexpr size_t RAM_PAGES = 8;     // 2KB of internal RAM, mirrors folded.
+
+    struct Block
+    {
+        uint32_t first; // index into ops.
+        uint16_t start;
+        uint8_t count;
+        // most cycles the ops before the last one can take.
+        uint16_t prefix_cycles;
+        uint32_t hits;      // entries counted by the JIT tier.
+        NativeBlock native; // translated code, nullptr until hot.
+        // loop back to start that only reads RAM/ROM, see CPU::skip_idle.
+        bool idle;
+    };
+
+    std::vector<Block> blocks;
+    std::vector<DecodedOp> ops;
+    // pc -> block: pages[pc >> 8] picks a 256-entry table in entries
+    // (0 = no table), which holds block index + 1 (0 = not decoded).
+    uint16_t pages[256] = {};
+    std::vector<uint32_t> entries;
+    // non-zero if a cached block holds code from this physical RAM page.
+    uint8_t code_pages[RAM_PAGES] = {};
+
+    Block *find(uint16_t pc)
+    {
+        uint16_t table = this->pages[pc >> 8];
+        if (table == 0)
+        {
+            return nullptr;
+        }
+        uint32_t id = this->entries[(table - 1) * 256 + (pc & 0xFF)];
+        return id != 0 ? &this->blocks[id - 1] : nullptr;
+    }
+
+    // Registers ops[first, first + count) as the block starting at start.
+    Block &insert(uint16_t start, uint32_t first, uint8_t count, uint16_t prefix_cycles);
+
+    // true if `address` is RAM some cached block was decoded from.
+    bool is_code(uint16_t address) const
+    {
+        return address < 0x2000 && this->code_pages[(address & 0x7FF) >> 8] != 0;
+    }
+
+    void invalidate_ram();
+    void clear();
+};
+
+#endif // !BLOCK_CACHE_H
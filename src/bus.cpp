@@ -1,18 +1,222 @@
 #include "bus.h"
+#include <algorithm>
+#include <iterator>
+#include <utility>
 
-uint8_t Bus::mem_read(uint16_t address)
+namespace
 {
-    if (address >= RAM && address <= RAM_END)
+    void allocate_ram(std::shared_ptr<RamPage> *pages, bool *owned)
     {
-        uint16_t mirrored_addr = address & 0b00000111'11111111;
-        return this->cpu_vram[mirrored_addr];
+        for (size_t i = 0; i < Bus::RAM_PAGES; ++i)
+        {
+            pages[i] = std::make_shared<RamPage>();
+            owned[i] = true;
+        }
     }
-    else if (address >= PPU_REGISTERS && address <= PPU_REGISTERS_END)
+}
+
+Bus::Bus()
+{
+    allocate_ram(this->cpu_vram, this->owned);
+    this->map_pages();
+}
+
+Bus::Bus(Rom rom) : rom(std::make_shared<const Rom>(std::move(rom)))
+{
+    allocate_ram(this->cpu_vram, this->owned);
+    this->map_pages();
+}
+
+Bus::Bus(std::shared_ptr<const Rom> rom) : rom(std::move(rom))
+{
+    allocate_ram(this->cpu_vram, this->owned);
+    this->map_pages();
+}
+
+Bus::Bus(const Bus &parent, const std::shared_ptr<RamPage> *pages) : rom(parent.rom)
+{
+    std::copy(pages, pages + RAM_PAGES, this->cpu_vram);
+    this->copy_map(parent);
+}
+
+// copies get their own RAM, fork() shares it.
+Bus::Bus(const Bus &other) : rom(other.rom)
+{
+    for (size_t i = 0; i < RAM_PAGES; ++i)
+    {
+        this->cpu_vram[i] = std::make_shared<RamPage>(*other.cpu_vram[i]);
+        this->owned[i] = true;
+    }
+    this->copy_map(other);
+}
+
+// the pages move over, the moved-from Bus has no RAM until it writes.
+Bus::Bus(Bus &&other) noexcept : rom(std::move(other.rom))
+{
+    std::move(std::begin(other.cpu_vram), std::end(other.cpu_vram), this->cpu_vram);
+    std::copy(std::begin(other.owned), std::end(other.owned), this->owned);
+    std::fill(std::begin(other.owned), std::end(other.owned), false);
+    this->copy_map(other);
+    other.map_pages();
+}
+
+Bus &Bus::operator=(const Bus &other)
+{
+    if (this != &other)
+    {
+        for (size_t i = 0; i < RAM_PAGES; ++i)
+        {
+            this->cpu_vram[i] = std::make_shared<RamPage>(*other.cpu_vram[i]);
+            this->owned[i] = true;
+        }
+        this->rom = other.rom;
+        this->copy_map(other);
+    }
+    return *this;
+}
+
+Bus &Bus::operator=(Bus &&other) noexcept
+{
+    if (this != &other)
+    {
+        std::move(std::begin(other.cpu_vram), std::end(other.cpu_vram), this->cpu_vram);
+        std::copy(std::begin(other.owned), std::end(other.owned), this->owned);
+        std::fill(std::begin(other.owned), std::end(other.owned), false);
+        this->rom = std::move(other.rom);
+        this->copy_map(other);
+        other.map_pages();
+    }
+    return *this;
+}
+
+void Bus::load_rom(std::shared_ptr<const Rom> rom)
+{
+    this->rom = std::move(rom);
+    this->map_pages();
+}
+
+Bus Bus::fork()
+{
+    Bus child(*this, this->cpu_vram);
+    // our own writes have to copy from now on too.
+    for (size_t i = 0; i < RAM_PAGES; ++i)
+    {
+        this->owned[i] = false;
+        this->map_ram_page(i);
+    }
+    return child;
+}
+
+void Bus::unshare(uint16_t address)
+{
+    size_t index = (address & (RAM_SIZE - 1)) / PAGE_SIZE;
+    std::shared_ptr<RamPage> &page = this->cpu_vram[index];
+    if (!this->owned[index])
+    {
+        page = page ? std::make_shared<RamPage>(*page) : std::make_shared<RamPage>();
+        this->owned[index] = true;
+    }
+    this->map_ram_page(index);
+}
+
+void Bus::read_ram(uint8_t *out) const
+{
+    for (size_t i = 0; i < RAM_PAGES; ++i)
+    {
+        if (this->cpu_vram[i])
+        {
+            std::copy(std::begin(this->cpu_vram[i]->bytes), std::end(this->cpu_vram[i]->bytes), out + i * PAGE_SIZE);
+        }
+        else
+        {
+            std::fill(out + i * PAGE_SIZE, out + (i + 1) * PAGE_SIZE, 0);
+        }
+    }
+}
+
+void Bus::write_ram(const uint8_t *in)
+{
+    for (size_t i = 0; i < RAM_PAGES; ++i)
+    {
+        // the old contents are overwritten, no need to copy a shared page.
+        if (!this->owned[i])
+        {
+            this->cpu_vram[i] = std::make_shared<RamPage>();
+            this->owned[i] = true;
+        }
+        std::copy(in + i * PAGE_SIZE, in + (i + 1) * PAGE_SIZE, this->cpu_vram[i]->bytes);
+        this->map_ram_page(i);
+    }
+}
+
+void Bus::map_pages()
+{
+    for (size_t page = 0; page < PAGE_COUNT; ++page)
+    {
+        uint16_t address = static_cast<uint16_t>(page * PAGE_SIZE);
+        this->read_pages[page] = nullptr;
+        this->write_pages[page] = nullptr;
+
+        if (address >= PRG_ROM && this->rom)
+        {
+            size_t offset = address - PRG_ROM;
+            // mirror address if needed.
+            if (this->rom->prg_rom.size() == 0x4000)
+            {
+                offset %= 0x4000;
+            }
+            if (offset + PAGE_SIZE <= this->rom->prg_rom.size())
+            {
+                this->read_pages[page] = this->rom->prg_rom.data() + offset;
+            }
+        }
+    }
+    for (size_t i = 0; i < RAM_PAGES; ++i)
+    {
+        this->map_ram_page(i);
+    }
+}
+
+// Same cartridge mapping as `other`, RAM mapped from our own pages.
+void Bus::copy_map(const Bus &other)
+{
+    std::copy(std::begin(other.read_pages), std::end(other.read_pages), this->read_pages);
+    std::copy(std::begin(other.write_pages), std::end(other.write_pages), this->write_pages);
+    for (size_t i = 0; i < RAM_PAGES; ++i)
+    {
+        this->map_ram_page(i);
+    }
+}
+
+// Maps RAM page `index` at all its mirrors, writable only if owned.
+void Bus::map_ram_page(size_t index)
+{
+    RamPage *page = this->cpu_vram[index].get();
+    bool writable = page != nullptr && this->owned[index];
+    for (size_t mirror = index; mirror <= RAM_END / PAGE_SIZE; mirror += RAM_PAGES)
+    {
+        this->read_pages[mirror] = page != nullptr ? page->bytes : nullptr;
+        this->write_pages[mirror] = writable ? page->bytes : nullptr;
+    }
+}
+
+uint8_t Bus::io_read(uint16_t address)
+{
+    if (address >= PPU_REGISTERS && address <= PPU_REGISTERS_END)
     {
         // uint16_t _mirrored_addr = address & 0b00100000'00000111;
         std::cout << "PPU not implemented yet\n";
         return 0x00;
     }
+    else if (address >= PRG_ROM && this->rom && !this->rom->prg_rom.empty())
+    {
+        return read_prog_rom(address);
+    }
+    else if (address <= RAM_END)
+    {
+        // only a moved-from Bus has unmapped RAM.
+        return 0x00;
+    }
     else
     {
         std::cout << "Invalid address\n";
@@ -20,35 +224,40 @@ uint8_t Bus::mem_read(uint16_t address)
     }
 }
 
-uint16_t Bus::mem_read_u16(uint16_t address)
+bool Bus::io_write(uint16_t address, uint8_t value)
 {
-    uint16_t lo = static_cast<uint16_t>(this->mem_read(address));
-    uint16_t hi = static_cast<uint16_t>(this->mem_read(address + 1));
-    return (hi << 8) | lo;
-}
-
-void Bus::mem_write(uint16_t address, uint8_t value)
-{
-    if (address >= RAM && address <= RAM_END)
+    if (address <= RAM_END)
     {
-        uint16_t mirrored_addr = address & 0b00000111'11111111;
-        this->cpu_vram[mirrored_addr] = value;
+        // first write to a page shared with a fork.
+        this->unshare(address);
+        this->write_pages[address >> 8][address & 0xFF] = value;
     }
     else if (address >= PPU_REGISTERS && address <= PPU_REGISTERS_END)
     {
         // uint16_t _mirrored_addr = address & 0b00100000'00000111;
         std::cout << "PPU not implemented yet\n";
     }
+    else if (address >= PRG_ROM)
+    {
+        // the CPU reports it as StopReason::BusFault.
+        return false;
+    }
     else
     {
-        std::cout << "Invalid address on mem_write: "<< static_cast<int>(address) <<"\n";
+        std::cout << "Invalid address\n";
     }
+    return true;
 }
 
-void Bus::mem_write_u16(uint16_t address, uint16_t value)
+uint8_t Bus::read_prog_rom(uint16_t address)
 {
-    uint8_t lo = value & 0xFF;
-    uint8_t hi = value >> 8;
-    this->mem_write(address, lo);
-    this->mem_write(address + 1, hi);
-}
\ No newline at end of file
+    address -= PRG_ROM;
+
+    // mirror address if needed.
+    if ((this->rom->prg_rom.size() == 0x4000) && (address >= 0x4000))
+    {
+        address %= 0x4000;
+    }
+
+    return this->rom->prg_rom[address];
+}
@@ -3,22 +3,119 @@
 
 #include <cstdint>
 #include <iostream>
+#include <memory>
+#include "rom.h"
+#include "global.h"
 const uint16_t RAM = 0x0000;
 const uint16_t RAM_END = 0x1FFF;
+const size_t RAM_SIZE = 0x800; // mirrored up to RAM_END.
 
 const uint16_t PPU_REGISTERS = 0x2000;
 const uint16_t PPU_REGISTERS_END = 0x3FFF;
 
-struct Bus
+const uint16_t PRG_ROM = 0x8000;
+
+// CPU address space split in 256-byte pages for the memory map.
+const size_t PAGE_SIZE = 0x100;
+const size_t PAGE_COUNT = 0x100;
+
+// One page of internal RAM.
+struct RamPage
+{
+    uint8_t bytes[PAGE_SIZE] = {};
+};
+
+struct Bus final : public Mem<Bus>
 {
-    uint8_t cpu_vram[2048];
+    static constexpr size_t RAM_PAGES = RAM_SIZE / PAGE_SIZE;
 
-    Bus(){};
+    // Internal RAM by page. A page is shared with forks until one of them
+    // writes it, shared pages are mapped read-only and the write copies it
+    // (see owned).
+    std::shared_ptr<RamPage> cpu_vram[RAM_PAGES];
+    // immutable and shared by every Bus running the same cartridge.
+    std::shared_ptr<const Rom> rom;
+    Bus();
+    explicit Bus(Rom rom);
+    explicit Bus(std::shared_ptr<const Rom> rom);
+    Bus(const Bus &other);
+    Bus(Bus &&other) noexcept;
+    Bus &operator=(const Bus &other);
+    Bus &operator=(Bus &&other) noexcept;
 
     uint8_t mem_read(uint16_t address);
-    void mem_write(uint16_t address, uint8_t value);
-    uint16_t mem_read_u16(uint16_t address);
-    void mem_write_u16(uint16_t address, uint16_t value);
+    // false on a bus fault (a write to ROM), the write is dropped.
+    bool mem_write(uint16_t address, uint8_t value);
+    // read without side effects for tracing, I/O pages read as 0.
+    uint8_t peek(uint16_t address) const;
+    // true for RAM/ROM, false for I/O and unmapped addresses.
+    bool is_mapped(uint16_t address) const { return this->read_pages[address >> 8] != nullptr; }
+    uint8_t read_prog_rom(uint16_t address);
+    // swaps the cartridge, RAM is kept.
+    void load_rom(std::shared_ptr<const Rom> rom);
+
+    // A Bus sharing this one's RAM pages copy-on-write, and the cartridge.
+    Bus fork();
+    // Makes the RAM page holding `address` private and writable.
+    void unshare(uint16_t address);
+    // Whole RAM to/from a 2KB buffer.
+    void read_ram(uint8_t *out) const;
+    void write_ram(const uint8_t *in);
+
+    // The memory map, for generated code that reads it directly.
+    const uint8_t *const *read_map() const { return this->read_pages; }
+    uint8_t *const *write_map() const { return this->write_pages; }
+
+private:
+    // parent's cartridge and `pages`, used by fork().
+    Bus(const Bus &parent, const std::shared_ptr<RamPage> *pages);
+
+    // Memory map built once per Bus: RAM mirrors and PRG ROM banks (16KB
+    // mirroring already applied) point straight at their backing bytes,
+    // nullptr pages go through io_read/io_write, as do writes to shared RAM.
+    const uint8_t *read_pages[PAGE_COUNT];
+    uint8_t *write_pages[PAGE_COUNT];
+    // Pages this Bus created and never shared, the only ones written in
+    // place. Set here rather than read from use_count(), which forks on
+    // other threads change under us: once shared, a page is copied by
+    // every side that writes it, even if the others have dropped it.
+    bool owned[RAM_PAGES] = {};
+
+    void map_pages();
+    void copy_map(const Bus &other);
+    void map_ram_page(size_t index);
+    uint8_t io_read(uint16_t address);
+    bool io_write(uint16_t address, uint8_t value);
 };
 
-#endif // !BUS_H
\ No newline at end of file
+// Defined in the header so CPU::mem_read inlines down to a table lookup.
+inline uint8_t Bus::mem_read(uint16_t address)
+{
+    const uint8_t *page = this->read_pages[address >> 8];
+    if (page != nullptr)
+    {
+        return page[address & 0xFF];
+    }
+    return this->io_read(address);
+}
+
+// Mapped pages always succeed, so once inlined callers only test the
+// result on the io_write path.
+inline bool Bus::mem_write(uint16_t address, uint8_t value)
+{
+    uint8_t *page = this->write_pages[address >> 8];
+    if (page != nullptr)
+    {
+        page[address & 0xFF] = value;
+        return true;
+    }
+    return this->io_write(address, value);
+}
+
+inline uint8_t Bus::peek(uint16_t address) const
+{
+    const uint8_t *page = this->read_pages[address >> 8];
+    return page != nullptr ? page[address & 0xFF] : 0x00;
+}
+
+#endif // !BUS_H
@@ -1,5 +1,9 @@
 #include "cpu.h"
+#include "fusion.h"
+#include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <utility>
 // helpers.
 void CPU::stack_push(uint8_t val)
 {
@@ -29,623 +33,925 @@ uint16_t CPU::stack_pop_u16()
     return (hi << 8) | lo;
 }
 
-uint8_t CPU::mem_read(uint16_t address)
+void CPU::reset()
 {
-    return this->bus.mem_read(address);
+    this->register_a = 0;
+    this->register_x = 0;
+    this->register_y = 0;
+    this->set_status(STATUS_RESET);
+    this->stack_pointer = STACK_RESET;
+    this->pc = this->mem_read_u16(RESET_VECTOR);
+    this->pending_interrupts = 0;
+    // ROM blocks stay valid, RAM may have been written through the bus.
+    this->invalidate_blocks(true);
+    // the reset sequence itself takes 7 cycles.
+    this->cycles = 7;
 }
 
-void CPU::mem_write(uint16_t address, uint8_t value)
+CPU CPU::fork()
 {
-    this->bus.mem_write(address, value);
+    CPU child{this->bus.fork()};
+    child.register_a = this->register_a;
+    child.register_x = this->register_x;
+    child.register_y = this->register_y;
+    child.set_status(this->get_status());
+    child.pc = this->pc;
+    child.stack_pointer = this->stack_pointer;
+    child.cycles = this->cycles;
+    child.pending_interrupts = this->pending_interrupts;
+    child.halt_on_brk = this->halt_on_brk;
+    child.skip_idle = this->skip_idle;
+#ifdef NES_JIT
+    child.jit_enabled = this->jit_enabled;
+    child.jit_threshold = this->jit_threshold;
+#endif
+    return child;
 }
 
-// Little-endian read.
-uint16_t CPU::mem_read_u16(uint16_t address)
+void CPU::interrupt(uint16_t vector, bool brk)
 {
-    return this->bus.mem_read_u16(address);
+    this->stack_push_u16(this->pc);
+    uint8_t status = this->get_status() | cpu_flags::UNUSED;
+    if (brk)
+    {
+        status |= cpu_flags::BREAK;
+    }
+    else
+    {
+        status &= ~cpu_flags::BREAK;
+    }
+    this->stack_push(status);
+    this->status |= cpu_flags::INTERRUPT;
+    this->pc = this->mem_read_u16(vector);
 }
 
-// Little-endian write.
-void CPU::mem_write_u16(uint16_t address, uint16_t value)
+// A stop request wins, then NMI, then IRQ, which waits while I is set.
+bool CPU::poll_interrupts()
 {
-    this->bus.mem_write_u16(address, value);
+    if (this->pending_interrupts & interrupts::STOP)
+    {
+        this->pending_interrupts &= ~interrupts::STOP;
+        return false;
+    }
+    if (this->pending_interrupts & interrupts::NMI)
+    {
+        this->pending_interrupts &= ~interrupts::NMI;
+        this->interrupt(NMI_VECTOR, false);
+    }
+    else if ((this->pending_interrupts & interrupts::IRQ) && !(this->status & cpu_flags::INTERRUPT))
+    {
+        this->interrupt(IRQ_VECTOR, false);
+    }
+    else
+    {
+        return true;
+    }
+    this->cycles += INTERRUPT_CYCLES;
+    // the handler starts a new block.
+    this->block_left = 0;
+    return true;
 }
 
-void CPU::reset()
+const char *stop_reason_name(StopReason reason)
 {
-    this->register_a = 0;
-    this->register_x = 0;
-    this->register_y = 0;
-    this->status = STATUS_RESET;
-    this->stack_pointer = STACK_RESET;
-    this->pc = this->mem_read_u16(0xFFFC);
+    switch (reason)
+    {
+    case StopReason::Budget:
+        return "budget";
+    case StopReason::Break:
+        return "BRK";
+    case StopReason::Halt:
+        return "JAM";
+    case StopReason::BusFault:
+        return "bus fault";
+    case StopReason::HostRequest:
+        return "host request";
+    }
+    return "unknown";
 }
 
 void CPU::load_and_run(std::vector<uint8_t> program)
 {
-    init_op_codes_map();
     this->load(program);
     this->reset();
     this->run();
 }
 
-// modified for snake game.
+// ROM space is read-only on the bus, so the program is wrapped in a 32KB
+// cartridge image with the reset vector pointing at PROGRAM_START.
 void CPU::load(std::vector<uint8_t> program)
 {
-    init_op_codes_map();
-    for (size_t i = 0; i < program.size(); ++i)
-    {
-        this->mem_write(0x8000 + i, program[i]);
-    }
-    this->mem_write_u16(0xFFFC, 0x8000);
+    std::vector<uint8_t> raw(NES_HEADER_SIZE + PRG_ROM_PAGE_SIZE * 2, 0);
+    std::copy(std::begin(NES_TAG), std::end(NES_TAG), raw.begin());
+    raw[4] = 2;
+
+    uint8_t *prg_rom = raw.data() + NES_HEADER_SIZE;
+    std::copy(program.begin(), program.end(), prg_rom + (PROGRAM_START - PRG_ROM));
+    prg_rom[0xFFFC - PRG_ROM] = static_cast<uint8_t>(PROGRAM_START & 0xFF);
+    prg_rom[0xFFFD - PRG_ROM] = static_cast<uint8_t>(PROGRAM_START >> 8);
+
+    this->bus.load_rom(std::make_shared<const Rom>(std::move(raw)));
+    this->invalidate_blocks();
 }
 
-void CPU::run()
+StopReason CPU::run()
 {
-    this->run_with_callback([](CPU &) {});
+    auto never = [](CPU &)
+    { return false; };
+    return this->run_until(never, [](CPU &, uint64_t, uint64_t)
+                           { return true; });
 }
 
-void CPU::run_with_callback(std::function<void(CPU &)> callback)
+StopReason CPU::run_with_callback(std::function<void(CPU &)> callback)
 {
-    while (true)
+    return this->run_with(callback);
+}
+
+StopReason CPU::run_for_instructions(uint64_t count)
+{
+    uint64_t executed = 0;
+    return this->run_for_instructions(count, executed);
+}
+
+StopReason CPU::run_for_instructions(uint64_t count, uint64_t &instructions)
+{
+    uint64_t end = instructions + count;
+    auto stop = [&](CPU &)
     {
-        // std::cerr << "PC at: " << std::hex << static_cast<int>(this->pc) << std::endl;
-        uint8_t code = this->mem_read(this->pc);
-        this->pc += 1;
-        uint16_t pc_state = this->pc;
-
-        OpCode opcode = OP_CODES_MAP[code];
-        // std::cerr << "opcode: " << std::hex << static_cast<int>(opcode.opcode) << " with mode: " << opcode.mode << std::endl;
-
-        switch (code)
-        {
-        // LDA
-        case 0xA9:
-        case 0xA5:
-        case 0xB5:
-        case 0xAD:
-        case 0xBD:
-        case 0xB9:
-        case 0xA1:
-        case 0xB1:
-        {
-            this->lda(opcode.mode);
-            break;
+        if (instructions == end)
+        {
+            return true;
+        }
+        instructions++;
+        return false;
+    };
+    StopReason reason = this->run_until(stop, [&](CPU &, uint64_t ops, uint64_t)
+                                        {
+                                            if (instructions + ops > end)
+                                            {
+                                                return false;
+                                            }
+                                            instructions += ops;
+                                            return true; });
+    // stop() counted the op before it ran.
+    if (reason == StopReason::Break || reason == StopReason::Halt)
+    {
+        instructions--;
+    }
+    return reason;
+}
+
+// One handler per opcode, instantiated from the decode table so the
+// addressing mode of every handler is a compile-time constant.
+namespace
+{
+    template <uint8_t code>
+    bool op_handler(CPU &cpu)
+    {
+        constexpr const OpCode &op = OP_CODES[code];
+        constexpr AddressingMode mode = op.mode;
+        constexpr bool accumulator = mode == AddressingMode::NoneAddressing;
+        [[maybe_unused]] uint16_t pc_state = cpu.pc;
+
+        cpu.cycles += op.cycles;
+
+        if constexpr (is_op(op, "BRK"))
+        {
+            if (cpu.halt_on_brk)
+            {
+                cpu.stop_reason = StopReason::Break;
+                return false;
+            }
+            cpu.brk();
         }
-        case 0x85:
-        case 0x95:
-        case 0x8D:
-        case 0x9D:
-        case 0x99:
-        case 0x81:
-        case 0x91:
+        else if constexpr (is_op(op, "NOP"))
         {
-            this->sta(opcode.mode);
-            break;
         }
-
-        // ADC
-        case 0x69:
-        case 0x65:
-        case 0x75:
-        case 0x6D:
-        case 0x7D:
-        case 0x79:
-        case 0x61:
-        case 0x71:
+        else if constexpr (is_op(op, "LDA"))
         {
-            this->adc(opcode.mode);
-            break;
+            cpu.lda<mode>();
         }
-
-        // SBC
-        case 0xE9:
-        case 0xE5:
-        case 0xF5:
-        case 0xED:
-        case 0xFD:
-        case 0xF9:
-        case 0xE1:
-        case 0xF1:
+        else if constexpr (is_op(op, "LDX"))
         {
-            this->sbc(opcode.mode);
-            break;
+            cpu.ldx<mode>();
         }
-
-        // AND
-        case 0x29:
-        case 0x25:
-        case 0x35:
-        case 0x2D:
-        case 0x3D:
-        case 0x39:
-        case 0x21:
-        case 0x31:
+        else if constexpr (is_op(op, "LDY"))
         {
-            this->and_op(opcode.mode);
-            break;
+            cpu.ldy<mode>();
         }
-
-        // ASL Accumulator
-        case 0x0A:
+        else if constexpr (is_op(op, "STA"))
         {
-            this->asl_acc();
-            break;
+            cpu.sta<mode>();
         }
-        case 0x06:
-        case 0x16:
-        case 0x0E:
-        case 0x1E:
+        else if constexpr (is_op(op, "STX"))
         {
-            this->asl(opcode.mode);
-            break;
+            cpu.stx<mode>();
         }
-
-        // BCC
-        case 0x90:
+        else if constexpr (is_op(op, "STY"))
         {
-            this->branch(!(this->status & cpu_flags::CARRY));
-            break;
+            cpu.sty<mode>();
         }
-
-        // BCS
-        case 0xB0:
+        else if constexpr (is_op(op, "ADC"))
         {
-            this->branch((this->status & cpu_flags::CARRY));
-            break;
+            cpu.adc<mode>();
         }
-
-        // BEQ
-        case 0xF0:
+        else if constexpr (is_op(op, "SBC"))
         {
-            this->branch((this->status & cpu_flags::ZERO));
-            break;
+            cpu.sbc<mode>();
         }
-
-        // BIT
-        case 0x24:
-        case 0x2C:
+        else if constexpr (is_op(op, "AND"))
         {
-            this->bit(opcode.mode);
-            break;
+            cpu.and_op<mode>();
         }
-
-        // BMI
-        case 0x30:
+        else if constexpr (is_op(op, "EOR"))
         {
-            this->branch((this->status & cpu_flags::NEGATIVE));
-            break;
+            cpu.eor<mode>();
         }
-
-        // BNE
-        case 0xD0:
+        else if constexpr (is_op(op, "ORA"))
         {
-            this->branch(!(this->status & cpu_flags::ZERO));
-            break;
+            cpu.ora<mode>();
         }
-
-        // BPL
-        case 0x10:
+        else if constexpr (is_op(op, "ASL"))
         {
-            this->branch(!(this->status & cpu_flags::NEGATIVE));
-            break;
+            if constexpr (accumulator)
+            {
+                cpu.asl_acc();
+            }
+            else
+            {
+                cpu.asl<mode>();
+            }
         }
-
-        // BRK
-        case 0x00:
+        else if constexpr (is_op(op, "LSR"))
         {
-            return;
+            if constexpr (accumulator)
+            {
+                cpu.lsr_acc();
+            }
+            else
+            {
+                cpu.lsr<mode>();
+            }
         }
-
-        // BVC
-        case 0x50:
+        else if constexpr (is_op(op, "ROL"))
         {
-            this->branch(!(this->status & cpu_flags::OVERFLW));
-            break;
+            if constexpr (accumulator)
+            {
+                cpu.rol_acc();
+            }
+            else
+            {
+                cpu.rol<mode>();
+            }
         }
-
-        // BVS
-        case 0x70:
+        else if constexpr (is_op(op, "ROR"))
         {
-            this->branch((this->status & cpu_flags::OVERFLW));
-            break;
+            if constexpr (accumulator)
+            {
+                cpu.ror_acc();
+            }
+            else
+            {
+                cpu.ror<mode>();
+            }
         }
-
-        // CLC
-        case 0x18:
+        else if constexpr (is_op(op, "INC"))
         {
-            this->status &= ~cpu_flags::CARRY;
-            break;
+            cpu.inc<mode>();
         }
-
-        // CLD
-        case 0xD8:
+        else if constexpr (is_op(op, "DEC"))
         {
-            this->status &= ~cpu_flags::DECIMAL_UNUSED;
-            break;
+            cpu.dec<mode>();
         }
-
-        // CLI
-        case 0x58:
+        else if constexpr (is_op(op, "INX"))
         {
-            this->status &= ~cpu_flags::INTERRUPT;
-            break;
+            cpu.inx();
         }
-
-        // CLV
-        case 0xB8:
+        else if constexpr (is_op(op, "INY"))
         {
-            this->status &= ~cpu_flags::OVERFLW;
-            break;
+            cpu.iny();
         }
-
-        // CMP
-        case 0xC9:
-        case 0xC5:
-        case 0xD5:
-        case 0xCD:
-        case 0xDD:
-        case 0xD9:
-        case 0xC1:
-        case 0xD1:
+        else if constexpr (is_op(op, "DEX"))
         {
-            this->cmp_op(opcode.mode, this->register_a);
-            break;
+            cpu.dex();
         }
-
-        // CPX
-        case 0xE0:
-        case 0xE4:
-        case 0xEC:
+        else if constexpr (is_op(op, "DEY"))
         {
-            this->cmp_op(opcode.mode, this->register_x);
-            break;
+            cpu.dey();
         }
-
-        // CPY
-        case 0xC0:
-        case 0xC4:
-        case 0xCC:
+        else if constexpr (is_op(op, "CMP"))
         {
-            this->cmp_op(opcode.mode, this->register_y);
-            break;
+            cpu.cmp_op<mode>(cpu.register_a);
         }
-
-        // DEC
-        case 0xC6:
-        case 0xD6:
-        case 0xCE:
-        case 0xDE:
+        else if constexpr (is_op(op, "CPX"))
         {
-            this->dec(opcode.mode);
-            break;
+            cpu.cmp_op<mode>(cpu.register_x);
         }
-
-        // DEX
-        case 0xCA:
+        else if constexpr (is_op(op, "CPY"))
         {
-            this->dex();
-            break;
+            cpu.cmp_op<mode>(cpu.register_y);
         }
-
-        // DEY
-        case 0x88:
+        else if constexpr (is_op(op, "BIT"))
         {
-            this->dey();
-            break;
+            cpu.bit<mode>();
         }
-
-        // EOR
-        case 0x49:
-        case 0x45:
-        case 0x55:
-        case 0x4D:
-        case 0x5D:
-        case 0x59:
-        case 0x41:
-        case 0x51:
+        else if constexpr (code == 0x4C)
         {
-            this->eor(opcode.mode);
-            break;
+            cpu.jmp_abs();
         }
-
-        // INC
-        case 0xE6:
-        case 0xF6:
-        case 0xEE:
-        case 0xFE:
+        else if constexpr (code == 0x6C)
         {
-            this->inc(opcode.mode);
-            break;
+            cpu.jmp();
         }
-
-        // INX
-        case 0xE8:
+        else if constexpr (is_op(op, "JSR"))
         {
-            this->inx();
-            break;
+            cpu.jsr();
         }
-
-        // INY
-        case 0xC8:
+        else if constexpr (is_op(op, "RTS"))
         {
-            this->iny();
-            break;
+            cpu.rts();
         }
-
-        // JMP Absolute
-        case 0x4C:
+        else if constexpr (is_op(op, "RTI"))
         {
-            this->jmp_abs();
-            break;
+            cpu.rti();
         }
-
-        // JMP Indirect
-        case 0x6C:
+        else if constexpr (is_op(op, "BCC"))
         {
-            this->jmp();
-            break;
+            cpu.branch(!cpu.carry_flag());
         }
-
-        // JSR
-        case 0x20:
+        else if constexpr (is_op(op, "BCS"))
         {
-            this->jsr();
-            break;
+            cpu.branch(cpu.carry_flag());
         }
-
-        // LDX
-        case 0xA2:
-        case 0xA6:
-        case 0xB6:
-        case 0xAE:
-        case 0xBE:
+        else if constexpr (is_op(op, "BEQ"))
         {
-            this->ldx(opcode.mode);
-            break;
+            cpu.branch(cpu.zero_flag());
         }
-
-        // LDY
-        case 0xA0:
-        case 0xA4:
-        case 0xB4:
-        case 0xAC:
-        case 0xBC:
+        else if constexpr (is_op(op, "BNE"))
         {
-            this->ldy(opcode.mode);
-            break;
+            cpu.branch(!cpu.zero_flag());
         }
-
-        // LSR
-        case 0x4A:
+        else if constexpr (is_op(op, "BMI"))
         {
-            this->lsr_acc();
-            break;
+            cpu.branch(cpu.negative_flag());
         }
-        case 0x46:
-        case 0x56:
-        case 0x4E:
-        case 0x5E:
+        else if constexpr (is_op(op, "BPL"))
         {
-            this->lsr(opcode.mode);
-            break;
+            cpu.branch(!cpu.negative_flag());
         }
-
-        // NOP, NO OP.
-        case 0xEA:
+        else if constexpr (is_op(op, "BVC"))
         {
-            break;
+            cpu.branch(!cpu.overflow_flag());
         }
-
-        // ORA
-        case 0x09:
-        case 0x05:
-        case 0x15:
-        case 0x0D:
-        case 0x1D:
-        case 0x19:
-        case 0x01:
-        case 0x11:
+        else if constexpr (is_op(op, "BVS"))
         {
-            this->ora(opcode.mode);
-            break;
+            cpu.branch(cpu.overflow_flag());
         }
-
-        // PHA
-        case 0x48:
+        else if constexpr (is_op(op, "CLC"))
         {
-            this->pha();
-            break;
+            cpu.set_carry_flag(false);
         }
-
-        // PHP
-        case 0x08:
+        else if constexpr (is_op(op, "CLD"))
         {
-            this->php();
-            break;
+            cpu.status &= ~cpu_flags::DECIMAL_UNUSED;
         }
-
-        // PLA
-        case 0x68:
+        else if constexpr (is_op(op, "CLI"))
         {
-            this->pla();
-            break;
+            cpu.status &= ~cpu_flags::INTERRUPT;
         }
-
-        // PLP
-        case 0x28:
+        else if constexpr (is_op(op, "CLV"))
         {
-            this->plp();
-            break;
+            cpu.set_overflow_flag(false);
         }
-
-        // ROL Accumulator
-        case 0x2A:
+        else if constexpr (is_op(op, "SEC"))
         {
-            this->rol_acc();
-            break;
+            cpu.set_carry_flag(true);
         }
-
-        // ROL
-        case 0x26:
-        case 0x36:
-        case 0x2E:
-        case 0x3E:
+        else if constexpr (is_op(op, "SED"))
         {
-            this->rol(opcode.mode);
-            break;
+            cpu.status |= cpu_flags::DECIMAL_UNUSED;
         }
-
-        // ROR Accumulator
-        case 0x6A:
+        else if constexpr (is_op(op, "SEI"))
         {
-            this->ror_acc();
-            break;
+            cpu.status |= cpu_flags::INTERRUPT;
         }
-
-        // ROR
-        case 0x66:
-        case 0x76:
-        case 0x6E:
-        case 0x7E:
+        else if constexpr (is_op(op, "TAX"))
         {
-            this->ror(opcode.mode);
-            break;
+            cpu.tax();
         }
-
-        // RTI
-        case 0x40:
+        else if constexpr (is_op(op, "TAY"))
         {
-            this->rti();
-            break;
+            cpu.tay();
         }
-
-        // RTS
-        case 0x60:
+        else if constexpr (is_op(op, "TSX"))
         {
-            this->rts();
-            break;
+            cpu.tsx();
         }
-
-        // SEC
-        case 0x38:
+        else if constexpr (is_op(op, "TXA"))
         {
-            this->status |= cpu_flags::CARRY;
-            break;
+            cpu.txa();
         }
-
-        // SED
-        case 0xF8:
+        else if constexpr (is_op(op, "TXS"))
         {
-            this->status |= cpu_flags::DECIMAL_UNUSED;
-            break;
+            cpu.txs();
         }
-
-        // SEI
-        case 0x78:
+        else if constexpr (is_op(op, "TYA"))
         {
-            this->status |= cpu_flags::INTERRUPT;
-            break;
+            cpu.tya();
         }
-
-        // STX
-        case 0x86:
-        case 0x96:
-        case 0x8E:
+        else if constexpr (is_op(op, "PHA"))
         {
-            this->stx(opcode.mode);
-            break;
+            cpu.pha();
         }
-
-        // STY
-        case 0x84:
-        case 0x94:
-        case 0x8C:
+        else if constexpr (is_op(op, "PHP"))
         {
-            this->sty(opcode.mode);
-            break;
+            cpu.php();
         }
-
-        // TAX
-        case 0xAA:
+        else if constexpr (is_op(op, "PLA"))
         {
-            this->tax();
-            break;
+            cpu.pla();
         }
-
-        // TAY
-        case 0xA8:
+        else if constexpr (is_op(op, "PLP"))
         {
-            this->tay();
-            break;
+            cpu.plp();
+        }
+        /* Undocumented */
+        else if constexpr (is_op(op, "*NOP"))
+        {
+            // the operand is only read for its page crossing cycle.
+            if constexpr (op.page_cross)
+            {
+                cpu.get_operand_address<mode>();
+            }
+        }
+        else if constexpr (is_op(op, "*LAX"))
+        {
+            cpu.lda<mode>();
+            cpu.tax();
+        }
+        else if constexpr (is_op(op, "*SAX"))
+        {
+            cpu.sax<mode>();
+        }
+        else if constexpr (is_op(op, "*SBC"))
+        {
+            cpu.sbc<mode>();
+        }
+        else if constexpr (is_op(op, "*DCP"))
+        {
+            uint8_t val = cpu.dec<mode>();
+            cpu.compare(cpu.register_a, val);
+        }
+        else if constexpr (is_op(op, "*ISB"))
+        {
+            uint8_t val = cpu.inc<mode>();
+            cpu.add_to_register_a(~val);
+        }
+        else if constexpr (is_op(op, "*SLO"))
+        {
+            uint8_t val = cpu.asl<mode>();
+            cpu.set_register_a(cpu.register_a | val);
+        }
+        else if constexpr (is_op(op, "*RLA"))
+        {
+            uint8_t val = cpu.rol<mode>();
+            cpu.set_register_a(cpu.register_a & val);
+        }
+        else if constexpr (is_op(op, "*SRE"))
+        {
+            uint8_t val = cpu.lsr<mode>();
+            cpu.set_register_a(cpu.register_a ^ val);
+        }
+        else if constexpr (is_op(op, "*RRA"))
+        {
+            uint8_t val = cpu.ror<mode>();
+            cpu.add_to_register_a(val);
+        }
+        else if constexpr (is_op(op, "*ANC"))
+        {
+            cpu.and_op<mode>();
+            cpu.set_carry_flag(cpu.negative_flag());
+        }
+        else if constexpr (is_op(op, "*ALR"))
+        {
+            cpu.and_op<mode>();
+            cpu.lsr_acc();
+        }
+        else if constexpr (is_op(op, "*ARR"))
+        {
+            // C is bit 6 of the result, V is bit 6 xor bit 5.
+            cpu.and_op<mode>();
+            cpu.ror_acc();
+            cpu.set_carry_flag((cpu.register_a & 0x40) != 0);
+            cpu.set_overflow_flag((((cpu.register_a >> 6) ^ (cpu.register_a >> 5)) & 1) != 0);
+        }
+        else if constexpr (is_op(op, "*AXS"))
+        {
+            cpu.axs<mode>();
+        }
+        else if constexpr (is_op(op, "*XAA"))
+        {
+            // 0xEE stands in for the chip-dependent "magic" constant.
+            cpu.set_register_a((cpu.register_a | 0xEE) & cpu.register_x & cpu.read_operand<mode>());
+        }
+        else if constexpr (is_op(op, "*LXA"))
+        {
+            cpu.set_register_a((cpu.register_a | 0xEE) & cpu.read_operand<mode>());
+            cpu.tax();
+        }
+        else if constexpr (is_op(op, "*LAS"))
+        {
+            cpu.las<mode>();
+        }
+        else if constexpr (is_op(op, "*AHX"))
+        {
+            cpu.store_and_high<mode>(cpu.register_a & cpu.register_x);
+        }
+        else if constexpr (is_op(op, "*SHX"))
+        {
+            cpu.store_and_high<mode>(cpu.register_x);
+        }
+        else if constexpr (is_op(op, "*SHY"))
+        {
+            cpu.store_and_high<mode>(cpu.register_y);
+        }
+        else if constexpr (is_op(op, "*TAS"))
+        {
+            cpu.stack_pointer = cpu.register_a & cpu.register_x;
+            cpu.store_and_high<mode>(cpu.stack_pointer);
+        }
+        else if constexpr (is_op(op, "*JAM"))
+        {
+            // the CPU locks up on the opcode, stop like BRK does.
+            cpu.pc -= 1;
+            cpu.stop_reason = StopReason::Halt;
+            return false;
+        }
+        else
+        {
+            static_assert(!op.valid(), "opcode in the decode table has no handler");
         }
 
-        // TSX
-        case 0xBA:
+        if constexpr (op.page_cross)
         {
-            this->tsx();
-            break;
+            cpu.cycles += cpu.page_crossed;
         }
 
-        // TXA
-        case 0x8A:
+        if constexpr (is_control_flow(op))
         {
-            this->txa();
-            break;
+            if (cpu.pc == pc_state)
+            {
+                cpu.pc += static_cast<uint16_t>(op.len - 1);
+            }
         }
+        else
+        {
+            cpu.pc += static_cast<uint16_t>(op.len - 1);
+        }
+        return true;
+    }
+
+    template <size_t... codes>
+    constexpr std::array<OpHandler, 256> build_op_handlers(std::index_sequence<codes...>)
+    {
+        return {{&op_handler<static_cast<uint8_t>(codes)>...}};
+    }
+
+    constexpr std::array<OpHandler, 256> OP_HANDLERS = build_op_handlers(std::make_index_sequence<256>{});
 
-        // TXS
-        case 0x9A:
+    // The handlers of FUSED_OPS[index] back to back. Only the last op can
+    // stop the CPU or jump.
+    template <size_t index>
+    bool fused_handler(CPU &cpu)
+    {
+        constexpr const FusedOps &fused = FUSED_OPS[index];
+        op_handler<fused.codes[0]>(cpu);
+        cpu.pc++;
+        if constexpr (fused.count == 3)
         {
-            this->txs();
-            break;
+            op_handler<fused.codes[1]>(cpu);
+            cpu.pc++;
         }
+        return op_handler<fused.codes[fused.count - 1]>(cpu);
+    }
+
+    template <size_t... indexes>
+    constexpr std::array<OpHandler, FUSED_OPS_COUNT> build_fused_handlers(std::index_sequence<indexes...>)
+    {
+        return {{&fused_handler<indexes>...}};
+    }
 
-        // TYA
-        case 0x98:
+    constexpr std::array<OpHandler, FUSED_OPS_COUNT> FUSED_HANDLERS =
+        build_fused_handlers(std::make_index_sequence<FUSED_OPS_COUNT>{});
+
+    bool starts_run(const DecodedOp *ops, size_t count, const FusedOps &fused)
+    {
+        if (fused.count > count)
         {
-            this->tya();
-            break;
+            return false;
+        }
+        for (size_t i = 0; i < fused.count; ++i)
+        {
+            if (ops[i].opcode != fused.codes[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Marks the ops of a ROM block that start a FUSED_OPS run.
+    void fuse_ops(DecodedOp *ops, size_t count)
+    {
+        for (size_t i = 0; i + 1 < count; ++i)
+        {
+            for (size_t f = 0; f < FUSED_OPS_COUNT; ++f)
+            {
+                const FusedOps &fused = FUSED_OPS[f];
+                if (!starts_run(ops + i, count - i, fused))
+                {
+                    continue;
+                }
+                uint8_t prefix_cycles = 0;
+                for (size_t j = 0; j + 1 < fused.count; ++j)
+                {
+                    const OpCode &op = OP_CODES[fused.codes[j]];
+                    prefix_cycles += op.cycles + op.page_cross;
+                }
+                ops[i].fused = FUSED_HANDLERS[f];
+                ops[i].fused_count = fused.count;
+                ops[i].fused_prefix_cycles = prefix_cycles;
+                break;
+            }
         }
+    }
+
+    // Ops that write neither memory nor the stack.
+    constexpr bool reads_only(const OpCode &op)
+    {
+        return is_op(op, "LDA") || is_op(op, "LDX") || is_op(op, "LDY") || is_op(op, "*LAX") ||
+               is_op(op, "CMP") || is_op(op, "CPX") || is_op(op, "CPY") || is_op(op, "BIT") ||
+               is_op(op, "AND") || is_op(op, "ORA") || is_op(op, "EOR") || is_op(op, "ADC") ||
+               is_op(op, "SBC") || is_op(op, "TAX") || is_op(op, "TAY") || is_op(op, "TXA") ||
+               is_op(op, "TYA") || is_op(op, "INX") || is_op(op, "INY") || is_op(op, "DEX") ||
+               is_op(op, "DEY") || is_op(op, "CLC") || is_op(op, "SEC") || is_op(op, "CLV") ||
+               is_op(op, "NOP") || is_op(op, "*NOP");
+    }
 
+    // true if nothing the op at addr can read is I/O, whose reads have side
+    // effects. Indirect pointers could lead anywhere.
+    bool reads_mapped(const Bus &bus, uint16_t addr, const OpCode &op)
+    {
+        switch (op.mode)
+        {
+        case AddressingMode::Absolute:
+        case AddressingMode::AbsoluteX:
+        case AddressingMode::AbsoluteY:
+        {
+            uint16_t base = static_cast<uint16_t>(bus.peek(addr + 1) | bus.peek(addr + 2) << 8);
+            uint16_t last = op.mode == AddressingMode::Absolute ? base : base + 0xFF;
+            return bus.is_mapped(base) && bus.is_mapped(last);
+        }
+        case AddressingMode::IndirectX:
+        case AddressingMode::IndirectY:
+            return false;
         default:
+            return true;
+        }
+    }
+
+    // A block whose last op jumps or branches back to start and whose
+    // other ops only read RAM/ROM, e.g. LDA $10 / BEQ start.
+    bool is_idle_loop(const Bus &bus, uint16_t start, const DecodedOp *ops, size_t count)
+    {
+        uint16_t addr = start;
+        for (size_t i = 0; i + 1 < count; ++i)
         {
-            break;
+            const OpCode &op = OP_CODES[ops[i].opcode];
+            if (!reads_only(op) || !reads_mapped(bus, addr, op))
+            {
+                return false;
+            }
+            addr += ops[i].len;
         }
+        const OpCode &last = OP_CODES[ops[count - 1].opcode];
+        if (last.opcode == 0x4C) // JMP absolute
+        {
+            return (bus.peek(addr + 1) | bus.peek(addr + 2) << 8) == start;
         }
-        if (this->pc == pc_state)
+        // the other two-byte jumps are the relative branches.
+        if (is_control_flow(last) && last.len == 2)
         {
-            this->pc += static_cast<uint16_t>((opcode.len - 1));
+            return static_cast<uint16_t>(addr + 2 + static_cast<int8_t>(bus.peek(addr + 1))) == start;
         }
+        return false;
+    }
+}
 
-        callback(*this);
+StopReason CPU::run_for_cycles(uint64_t budget)
+{
+    uint64_t target = this->cycles + budget;
+    auto stop = [target](CPU &cpu)
+    { return cpu.cycles >= target; };
+    // every instruction but the last starts before target.
+    return this->run_until(stop, [target](CPU &cpu, uint64_t, uint64_t prefix_cycles)
+                           { return cpu.cycles + prefix_cycles < target; });
+}
+
+StopReason CPU::run_for_cycles(uint64_t budget, uint64_t &instructions)
+{
+    uint64_t target = this->cycles + budget;
+    auto stop = [&](CPU &cpu)
+    {
+        if (cpu.cycles >= target)
+        {
+            return true;
+        }
+        instructions++;
+        return false;
+    };
+    StopReason reason = this->run_until(stop, [&](CPU &cpu, uint64_t count, uint64_t prefix_cycles)
+                                        {
+                                            if (cpu.cycles + prefix_cycles >= target)
+                                            {
+                                                return false;
+                                            }
+                                            instructions += count;
+                                            return true; });
+    // stop() counted the op before it ran.
+    if (reason == StopReason::Break || reason == StopReason::Halt)
+    {
+        instructions--;
     }
-};
+    return reason;
+}
 
-void CPU::set_zero_and_negative_flags(uint8_t register_value)
+bool CPU::step()
 {
-    if (register_value == 0)
+    if (this->pending_interrupts != 0 && !this->poll_interrupts())
     {
-        this->status |= cpu_flags::ZERO;
+        return false;
     }
-    else
+#if defined(NES_BLOCK_CACHE)
+    return this->step_cached();
+#elif defined(NES_THREADED_DISPATCH)
+    return this->step_threaded();
+#else
+    return this->step_switch();
+#endif
+}
+
+// Switch core: a single switch whose cases are the same per-opcode
+// handlers the threaded core calls through its table.
+#define OP_CASE(n)                                   \
+    case n:                                          \
+        return op_handler<static_cast<uint8_t>(n)>(*this);
+#define OP_CASE_ROW(r)                                                        \
+    OP_CASE(0x##r##0) OP_CASE(0x##r##1) OP_CASE(0x##r##2) OP_CASE(0x##r##3)   \
+    OP_CASE(0x##r##4) OP_CASE(0x##r##5) OP_CASE(0x##r##6) OP_CASE(0x##r##7)   \
+    OP_CASE(0x##r##8) OP_CASE(0x##r##9) OP_CASE(0x##r##A) OP_CASE(0x##r##B)   \
+    OP_CASE(0x##r##C) OP_CASE(0x##r##D) OP_CASE(0x##r##E) OP_CASE(0x##r##F)
+
+bool CPU::step_switch()
+{
+    uint8_t code = this->mem_read(this->pc);
+
+    this->pc++;
+
+    switch (code)
     {
-        this->status &= ~cpu_flags::ZERO;
+        OP_CASE_ROW(0)
+        OP_CASE_ROW(1)
+        OP_CASE_ROW(2)
+        OP_CASE_ROW(3)
+        OP_CASE_ROW(4)
+        OP_CASE_ROW(5)
+        OP_CASE_ROW(6)
+        OP_CASE_ROW(7)
+        OP_CASE_ROW(8)
+        OP_CASE_ROW(9)
+        OP_CASE_ROW(A)
+        OP_CASE_ROW(B)
+        OP_CASE_ROW(C)
+        OP_CASE_ROW(D)
+        OP_CASE_ROW(E)
+        OP_CASE_ROW(F)
     }
+    return true;
+}
+
+#undef OP_CASE_ROW
+#undef OP_CASE
+
+bool CPU::step_threaded()
+{
+    uint8_t code = this->mem_read(this->pc);
+    this->pc++;
+    return OP_HANDLERS[code](*this);
+}
 
-    if ((register_value >> 7) == 1)
+// Decodes from start up to and including the first branch/jump (or BRK,
+// or an opcode with no handler), at most MAX_BLOCK_OPS instructions.
+// Returns nullptr for code outside RAM and ROM, which is interpreted.
+BlockCache::Block *CPU::decode_block(uint16_t start)
+{
+    bool ram = start <= RAM_END;
+    if ((!ram && start < PRG_ROM) || !this->bus.is_mapped(start))
     {
-        this->status |= cpu_flags::NEGATIVE;
+        return nullptr;
+    }
+
+    BlockCache &cache = this->block_cache;
+    if (cache.ops.size() + BlockCache::MAX_BLOCK_OPS > BlockCache::MAX_OPS)
+    {
+        this->invalidate_blocks();
+    }
+
+    uint32_t first = static_cast<uint32_t>(cache.ops.size());
+    uint16_t addr = start;
+    uint8_t count = 0;
+    uint16_t cycles = 0;
+    uint16_t prefix_cycles = 0;
+    while (count < BlockCache::MAX_BLOCK_OPS)
+    {
+        uint8_t code = this->bus.peek(addr);
+        const OpCode &op = OP_CODES[code];
+        uint8_t len = op.valid() ? op.len : 1;
+        prefix_cycles = cycles;
+        cycles += op.cycles + op.page_cross;
+        cache.ops.push_back(DecodedOp{OP_HANDLERS[code], code, len});
+        count++;
+        if (ends_block(op))
+        {
+            break;
+        }
+
+        // stop where the region (RAM or ROM) ends.
+        uint16_t next = addr + len;
+        if (next < addr || (ram && next > RAM_END))
+        {
+            break;
+        }
+        addr = next;
+    }
+    if (!ram)
+    {
+        // ROM only, in RAM the first op of a run could rewrite the next.
+        // A jump into the middle of a run decodes its own block from there.
+        fuse_ops(&cache.ops[first], count);
+    }
+    BlockCache::Block &block = cache.insert(start, first, count, prefix_cycles);
+    block.idle = is_idle_loop(this->bus, start, &cache.ops[first], count);
+    return &block;
+}
+
+bool CPU::step_cached()
+{
+    if (this->block_left == 0 || this->pc != this->block_pc)
+    {
+        const BlockCache::Block *block = this->block_cache.find(this->pc);
+        if (block == nullptr)
+        {
+            block = this->decode_block(this->pc);
+            if (block == nullptr)
+            {
+                return this->step_threaded();
+            }
+        }
+        this->block_next = block->first;
+        this->block_left = block->count;
+    }
+
+    const DecodedOp &op = this->block_cache.ops[this->block_next];
+    this->block_next++;
+    this->block_left--;
+    this->block_pc = this->pc + op.len;
+    this->pc++;
+    return op.handler(*this);
+}
+
+void CPU::invalidate_blocks(bool ram_only)
+{
+    if (ram_only)
+    {
+        this->block_cache.invalidate_ram();
     }
     else
     {
-        this->status &= ~cpu_flags::NEGATIVE;
+        this->block_cache.clear();
+#ifdef NES_JIT
+        // nothing points into the old code any more.
+        this->jit_buffer.reset();
+        this->jit_buffer_owner.owned = false;
+#endif
     }
+    this->block_left = 0;
 }
 
-void CPU::lda(AddressingMode mode)
+template <AddressingMode mode>
+void CPU::lda()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     uint8_t val = this->mem_read(addr);
     this->set_register_a(val);
 }
@@ -662,57 +968,28 @@ void CPU::inx()
     this->set_zero_and_negative_flags(this->register_x);
 }
 
-uint16_t CPU::get_operand_address(AddressingMode mode)
+// Runtime-mode variant for callers that only know the mode from the
+// decode table (e.g. trace()).
+uint16_t CPU::get_abs_address(AddressingMode mode, uint16_t begin)
 {
     switch (mode)
     {
-    case Immediate:
-        return this->pc;
     case ZeroPage:
-        return static_cast<uint16_t>(this->mem_read(this->pc));
+        return this->get_abs_address<ZeroPage>(begin);
     case Absolute:
-        return this->mem_read_u16(this->pc);
+        return this->get_abs_address<Absolute>(begin);
     case ZeroPageX:
-    {
-        uint8_t pos = this->mem_read(this->pc);
-        uint16_t addr = static_cast<uint16_t>((pos + this->register_x));
-        return addr;
-    }
+        return this->get_abs_address<ZeroPageX>(begin);
     case ZeroPageY:
-    {
-        uint8_t pos = this->mem_read(this->pc);
-        uint16_t addr = static_cast<uint16_t>((pos + this->register_y));
-        return addr;
-    }
+        return this->get_abs_address<ZeroPageY>(begin);
     case AbsoluteX:
-    {
-        uint16_t base = this->mem_read_u16(this->pc);
-        uint16_t addr = base + this->register_x;
-        return addr;
-    }
+        return this->get_abs_address<AbsoluteX>(begin);
     case AbsoluteY:
-    {
-        uint16_t base = this->mem_read_u16(this->pc);
-        uint16_t addr = base + this->register_y;
-        return addr;
-    }
+        return this->get_abs_address<AbsoluteY>(begin);
     case IndirectX:
-    {
-        uint8_t base = this->mem_read(this->pc);
-        uint8_t ptr = base + this->register_x;
-        uint16_t lo = this->mem_read(static_cast<uint16_t>(ptr));
-        uint16_t hi = this->mem_read(static_cast<uint16_t>(ptr + 1));
-        return (hi << 8) | lo;
-    }
+        return this->get_abs_address<IndirectX>(begin);
     case IndirectY:
-    {
-        uint8_t base = this->mem_read(this->pc);
-        uint16_t lo = this->mem_read(static_cast<uint16_t>(base));
-        uint16_t hi = this->mem_read(static_cast<uint16_t>(base + 1));
-        uint16_t deref_base = (hi << 8) | lo;
-        uint16_t deref = deref_base + static_cast<uint16_t>(this->register_y);
-        return deref;
-    }
+        return this->get_abs_address<IndirectY>(begin);
     case NoneAddressing:
     default:
     {
@@ -723,9 +1000,10 @@ uint16_t CPU::get_operand_address(AddressingMode mode)
     }
 }
 
-void CPU::sta(AddressingMode mode)
+template <AddressingMode mode>
+void CPU::sta()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     this->mem_write(addr, this->register_a);
 }
 
@@ -751,51 +1029,40 @@ void CPU::add_to_register_a(uint8_t val)
 {
     // add 1 if carry flag is set.
     uint16_t result = static_cast<uint16_t>(this->register_a) +
-                      static_cast<uint16_t>(val) + static_cast<uint16_t>(this->status & cpu_flags::CARRY);
+                      static_cast<uint16_t>(val) + static_cast<uint16_t>(this->carry_flag());
 
     // set carry flag if result is greater than 255, else unset.
     bool carry = result > 0xFF;
-    if (carry)
-    {
-        this->status |= cpu_flags::CARRY;
-    }
-    else
-    {
-        this->status &= ~cpu_flags::CARRY;
-    }
+    this->set_carry_flag(carry);
 
     uint8_t result8 = static_cast<uint8_t>(result);
 
     // set overflow flag if result is greater than 127, else unset.
-    if (((val ^ result8) & (result8 ^ this->register_a) & 0x80) != 0)
-    {
-        this->status |= cpu_flags::OVERFLW;
-    }
-    else
-    {
-        this->status &= ~cpu_flags::OVERFLW;
-    }
+    this->set_overflow_flag(((val ^ result8) & (result8 ^ this->register_a) & 0x80) != 0);
 
     this->set_register_a(result8);
 }
 
-void CPU::adc(AddressingMode mode)
+template <AddressingMode mode>
+void CPU::adc()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     uint8_t val = this->mem_read(addr);
     this->add_to_register_a(val);
 }
 
-void CPU::sbc(AddressingMode mode)
+template <AddressingMode mode>
+void CPU::sbc()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     int8_t val = static_cast<int8_t>(this->mem_read(addr));
     this->add_to_register_a(static_cast<uint8_t>((-val - 1)));
 }
 
-void CPU::and_op(AddressingMode mode)
+template <AddressingMode mode>
+void CPU::and_op()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     uint8_t val = this->mem_read(addr);
     this->set_register_a(val & this->register_a);
 }
@@ -804,33 +1071,20 @@ void CPU::asl_acc()
 {
     // set CARRY.
     uint8_t data = this->register_a;
-    if ((data >> 7) == 1)
-    {
-        this->status |= cpu_flags::CARRY;
-    }
-    else
-    {
-        this->status &= ~cpu_flags::CARRY;
-    }
+    this->set_carry_flag((data >> 7) == 1);
 
     data <<= 1;
     this->set_register_a(data);
 }
 
-uint8_t CPU::asl(AddressingMode mode)
+template <AddressingMode mode>
+uint8_t CPU::asl()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     uint8_t val = this->mem_read(addr);
 
     // set CARRY.
-    if ((val >> 7) == 1)
-    {
-        this->status |= cpu_flags::CARRY;
-    }
-    else
-    {
-        this->status &= ~cpu_flags::CARRY;
-    }
+    this->set_carry_flag((val >> 7) == 1);
 
     val <<= 1;
     this->mem_write(addr, val);
@@ -838,60 +1092,51 @@ uint8_t CPU::asl(AddressingMode mode)
     return val;
 }
 
+// +1 cycle if the branch is taken, +1 more if it lands on another page.
 void CPU::branch(bool cond)
 {
     if (cond)
     {
         int8_t jump = static_cast<int8_t>(this->mem_read(this->pc));
-        uint16_t jump_addr = this->pc + 1 + static_cast<uint16_t>(jump);
+        uint16_t next_addr = this->pc + 1;
+        uint16_t jump_addr = next_addr + static_cast<uint16_t>(jump);
+        this->cycles += 1;
+        if ((next_addr & 0xFF00) != (jump_addr & 0xFF00))
+        {
+            this->cycles += 1;
+        }
         this->pc = jump_addr;
     }
 }
 
-void CPU::bit(AddressingMode mode)
+template <AddressingMode mode>
+void CPU::bit()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     uint8_t val = this->mem_read(addr);
-    uint8_t result = this->register_a & val;
-    if (result == 0)
-    {
-        this->status |= cpu_flags::ZERO;
-    }
-    else
-    {
-        this->status &= ~cpu_flags::ZERO;
-    }
-
-    if ((val & 0b1000'0000) > 0)
-    {
-        this->status |= cpu_flags::NEGATIVE;
-    }
-
-    if ((val & 0b0100'0000) > 0)
-    {
-        this->status |= cpu_flags::OVERFLW;
-    }
+    // Z from A & M, N and V are copied from bits 7 and 6 of M.
+    this->set_zero_and_negative_flags(this->register_a & val, val);
+    this->set_overflow_flag((val & cpu_flags::OVERFLW) != 0);
 }
 
-void CPU::cmp_op(AddressingMode mode, uint8_t reg)
+template <AddressingMode mode>
+void CPU::cmp_op(uint8_t reg)
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     uint8_t val = this->mem_read(addr);
+    this->compare(reg, val);
+}
 
-    if (val <= reg)
-    {
-        this->status |= cpu_flags::CARRY;
-    }
-    else
-    {
-        this->status &= ~cpu_flags::CARRY;
-    }
+void CPU::compare(uint8_t reg, uint8_t val)
+{
+    this->set_carry_flag(val <= reg);
     this->set_zero_and_negative_flags((reg - val));
 }
 
-uint8_t CPU::dec(AddressingMode mode)
+template <AddressingMode mode>
+uint8_t CPU::dec()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     uint8_t val = this->mem_read(addr);
     val--;
     this->mem_write(addr, val);
@@ -911,16 +1156,18 @@ void CPU::dey()
     this->set_zero_and_negative_flags(this->register_y);
 }
 
-void CPU::eor(AddressingMode mode)
+template <AddressingMode mode>
+void CPU::eor()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     uint8_t val = this->mem_read(addr);
     this->set_register_a(val ^ this->register_a);
 }
 
-uint8_t CPU::inc(AddressingMode mode)
+template <AddressingMode mode>
+uint8_t CPU::inc()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     uint8_t val = this->mem_read(addr);
     val += 1;
     this->mem_write(addr, val);
@@ -965,17 +1212,19 @@ void CPU::jsr()
     this->pc = jump_addr;
 }
 
-void CPU::ldx(AddressingMode mode)
+template <AddressingMode mode>
+void CPU::ldx()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     uint8_t val = this->mem_read(addr);
     this->register_x = val;
     this->set_zero_and_negative_flags(this->register_x);
 }
 
-void CPU::ldy(AddressingMode mode)
+template <AddressingMode mode>
+void CPU::ldy()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     uint8_t val = this->mem_read(addr);
     this->register_y = val;
     this->set_zero_and_negative_flags(this->register_y);
@@ -986,41 +1235,29 @@ void CPU::lsr_acc()
 {
     uint8_t data = this->register_a;
     // old bit 0 is the new carry.
-    if ((data & 1) == 1)
-    {
-        this->status |= cpu_flags::CARRY;
-    }
-    else
-    {
-        this->status &= ~cpu_flags::CARRY;
-    }
+    this->set_carry_flag((data & 1) == 1);
     data >>= 1;
     this->set_register_a(data);
 }
 
-uint8_t CPU::lsr(AddressingMode mode)
+template <AddressingMode mode>
+uint8_t CPU::lsr()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     uint8_t val = this->mem_read(addr);
 
     // old bit 0 is the new carry.
-    if ((val & 1) != 0)
-    {
-        this->status |= cpu_flags::CARRY;
-    }
-    else
-    {
-        this->status &= ~cpu_flags::CARRY;
-    }
+    this->set_carry_flag((val & 1) != 0);
     val >>= 1;
     this->mem_write(addr, val);
     this->set_zero_and_negative_flags(val);
     return val;
 }
 
-void CPU::ora(AddressingMode mode)
+template <AddressingMode mode>
+void CPU::ora()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     uint8_t val = this->mem_read(addr);
     this->set_register_a(val | this->register_a);
 }
@@ -1035,12 +1272,19 @@ void CPU::pha()
 // none are these flags are used by the processor itself.
 void CPU::php()
 {
-    uint8_t status = this->status;
+    uint8_t status = this->get_status();
     status |= cpu_flags::BREAK;
     status |= cpu_flags::UNUSED;
     this->stack_push(status);
 }
 
+// the byte after BRK is padding, the handler returns past it.
+void CPU::brk()
+{
+    this->pc += 1;
+    this->interrupt(IRQ_VECTOR, true);
+}
+
 void CPU::pla()
 {
     uint8_t data = this->stack_pop();
@@ -1049,9 +1293,10 @@ void CPU::pla()
 
 void CPU::plp()
 {
-    this->status = this->stack_pop();
-    this->status &= ~cpu_flags::BREAK;
-    this->status |= cpu_flags::UNUSED; // reset this bit to 1.
+    uint8_t status = this->stack_pop();
+    status &= ~cpu_flags::BREAK;
+    status |= cpu_flags::UNUSED; // reset this bit to 1.
+    this->set_status(status);
 }
 
 // rotate to left, the accumulator.
@@ -1060,16 +1305,9 @@ void CPU::rol_acc()
     // old bit 7 becomes new carry.
     // bit 0 is the old carry.
     uint8_t data = this->register_a;
-    bool old_carry = (this->status & cpu_flags::CARRY) == 1;
+    bool old_carry = this->carry_flag();
 
-    if ((data >> 7) == 1)
-    {
-        this->status |= cpu_flags::CARRY;
-    }
-    else
-    {
-        this->status &= ~cpu_flags::CARRY;
-    }
+    this->set_carry_flag((data >> 7) == 1);
 
     data <<= 1;
     if (old_carry)
@@ -1079,23 +1317,17 @@ void CPU::rol_acc()
     this->set_register_a(data);
 }
 
-uint8_t CPU::rol(AddressingMode mode)
+template <AddressingMode mode>
+uint8_t CPU::rol()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     uint8_t val = this->mem_read(addr);
 
     // old bit 7 becomes new carry.
     // bit 0 is the old carry.
-    bool old_carry = (this->status & cpu_flags::CARRY) == 1;
+    bool old_carry = this->carry_flag();
 
-    if ((val >> 7) == 1)
-    {
-        this->status |= cpu_flags::CARRY;
-    }
-    else
-    {
-        this->status &= ~cpu_flags::CARRY;
-    }
+    this->set_carry_flag((val >> 7) == 1);
 
     val <<= 1;
     if (old_carry)
@@ -1112,16 +1344,9 @@ void CPU::ror_acc()
     // old bit 0 becomes new carry.
     // bit 7 is the old carry.
     uint8_t data = this->register_a;
-    bool old_carry = (this->status & cpu_flags::CARRY) == 1;
+    bool old_carry = this->carry_flag();
 
-    if ((data & 1) == 1)
-    {
-        this->status |= cpu_flags::CARRY;
-    }
-    else
-    {
-        this->status &= ~cpu_flags::CARRY;
-    }
+    this->set_carry_flag((data & 1) == 1);
 
     data >>= 1;
     if (old_carry)
@@ -1131,20 +1356,14 @@ void CPU::ror_acc()
     this->set_register_a(data);
 }
 
-uint8_t CPU::ror(AddressingMode mode)
+template <AddressingMode mode>
+uint8_t CPU::ror()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     uint8_t val = this->mem_read(addr);
 
-    bool old_carry = (this->status & cpu_flags::CARRY) == 1;
-    if ((val & 1) == 1)
-    {
-        this->status |= cpu_flags::CARRY;
-    }
-    else
-    {
-        this->status &= ~cpu_flags::CARRY;
-    }
+    bool old_carry = this->carry_flag();
+    this->set_carry_flag((val & 1) == 1);
 
     val >>= 1;
     if (old_carry)
@@ -1158,9 +1377,10 @@ uint8_t CPU::ror(AddressingMode mode)
 
 void CPU::rti()
 {
-    this->status = this->stack_pop();
-    this->status &= ~cpu_flags::BREAK;
-    this->status |= cpu_flags::UNUSED; // reset this bit to 1.
+    uint8_t status = this->stack_pop();
+    status &= ~cpu_flags::BREAK;
+    status |= cpu_flags::UNUSED; // reset this bit to 1.
+    this->set_status(status);
     this->pc = this->stack_pop_u16();
 }
 
@@ -1169,15 +1389,17 @@ void CPU::rts()
     this->pc = this->stack_pop_u16() + 1;
 }
 
-void CPU::stx(AddressingMode mode)
+template <AddressingMode mode>
+void CPU::stx()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     this->mem_write(addr, this->register_x);
 }
 
-void CPU::sty(AddressingMode mode)
+template <AddressingMode mode>
+void CPU::sty()
 {
-    uint16_t addr = this->get_operand_address(mode);
+    uint16_t addr = this->get_operand_address<mode>();
     this->mem_write(addr, this->register_y);
 }
 
@@ -1209,3 +1431,54 @@ void CPU::tya()
     this->register_a = this->register_y;
     this->set_zero_and_negative_flags(this->register_a);
 }
+
+template <AddressingMode mode>
+uint8_t CPU::read_operand()
+{
+    uint16_t addr = this->get_operand_address<mode>();
+    return this->mem_read(addr);
+}
+
+template <AddressingMode mode>
+void CPU::sax()
+{
+    uint16_t addr = this->get_operand_address<mode>();
+    this->mem_write(addr, this->register_a & this->register_x);
+}
+
+// X = (A & X) - M, flags as CMP of A & X against M.
+template <AddressingMode mode>
+void CPU::axs()
+{
+    uint8_t val = this->read_operand<mode>();
+    uint8_t ax = this->register_a & this->register_x;
+    this->compare(ax, val);
+    this->register_x = ax - val;
+}
+
+template <AddressingMode mode>
+void CPU::las()
+{
+    uint8_t val = this->read_operand<mode>() & this->stack_pointer;
+    this->register_a = val;
+    this->register_x = val;
+    this->stack_pointer = val;
+    this->set_zero_and_negative_flags(val);
+}
+
+// SHX, SHY, AHX and TAS store `val & (high byte of the base address + 1)`.
+// When indexing crosses a page the stored value also replaces the high byte
+// of the address.
+template <AddressingMode mode>
+void CPU::store_and_high(uint8_t val)
+{
+    uint16_t addr = this->get_operand_address<mode>();
+    uint8_t index = mode == AddressingMode::AbsoluteX ? this->register_x : this->register_y;
+    uint16_t base = addr - index;
+    val &= static_cast<uint8_t>((base >> 8) + 1);
+    if (this->page_crossed)
+    {
+        addr = (static_cast<uint16_t>(val) << 8) | (addr & 0x00FF);
+    }
+    this->mem_write(addr, val);
+}
@@ -5,7 +5,15 @@
 #include "opcode.h"
 #include "global.h"
 #include "bus.h"
+#include "block_cache.h"
+#include "save_state.h"
+#ifdef NES_JIT
+#include "jit.h"
+#include <memory>
+#endif
 #include <functional>
+#include <type_traits>
+#include <utility>
 
 // STACK in 6502 CPU is 256 bytes long, and it starts at 0x0100, ends at 0x01FF
 // Pointer initially points to 0x01FF.
@@ -15,6 +23,36 @@ const uint16_t STACK_START = 0x0100;
 const uint8_t STACK_RESET = 0xFD;
 
 const uint8_t STATUS_RESET = 0b00100100;
+
+// where load() places a bare program.
+const uint16_t PROGRAM_START = 0x8600;
+
+const uint16_t NMI_VECTOR = 0xFFFA;
+const uint16_t RESET_VECTOR = 0xFFFC;
+const uint16_t IRQ_VECTOR = 0xFFFE; // shared with BRK.
+// entering an interrupt handler takes 7 cycles, like BRK.
+const uint8_t INTERRUPT_CYCLES = 7;
+
+// bits of CPU::pending_interrupts.
+namespace interrupts
+{
+    static constexpr uint8_t NMI = 0b001; // edge, cleared once taken.
+    static constexpr uint8_t IRQ = 0b010; // level, held until the device drops it.
+    // not an interrupt: return from the run loop, see CPU::request_stop().
+    static constexpr uint8_t STOP = 0b100;
+};
+
+// Why a run returned. Every reason leaves the CPU resumable at an
+// instruction boundary.
+enum class StopReason : uint8_t
+{
+    Budget,      // the instruction/cycle budget or stop() condition was met.
+    Break,       // BRK with halt_on_brk set, pc is past the opcode.
+    Halt,        // a JAM opcode, pc stays on it.
+    BusFault,    // a write to ROM, ignored. CPU::fault_address has the address.
+    HostRequest, // request_stop() from a callback or device.
+};
+const char *stop_reason_name(StopReason reason);
 namespace cpu_flags
 {
     static constexpr uint8_t CARRY = 0b00000001;
@@ -26,30 +64,207 @@ namespace cpu_flags
     static constexpr uint8_t OVERFLW = 0b01000000;
     static constexpr uint8_t NEGATIVE = 0b10000000;
 };
-struct CPU
+struct CPU final : public Mem<CPU>
 {
     uint8_t register_a;
     uint8_t register_x;
     uint8_t register_y;
+    // With NES_LAZY_FLAGS only I/D/B/U are kept here and N/Z/C/V live in the
+    // lazy_* fields below, read the full byte with get_status().
     uint8_t status;
     uint16_t pc;
-    uint8_t memory[0xFFFF];
     uint8_t stack_pointer;
+    uint64_t cycles; // total CPU cycles since power on.
     Bus bus;
 
-    CPU() : register_a(0), register_x(0), register_y(0), status(STATUS_RESET), pc(0), stack_pointer(STACK_RESET){};
-    uint8_t mem_read(uint16_t address);
-    void mem_write(uint16_t address, uint8_t value);
-    uint16_t mem_read_u16(uint16_t address);
-    void mem_write_u16(uint16_t address, uint16_t value);
+    // set by indexed addressing, read back for the +1 page-cross penalty.
+    bool page_crossed;
+
+    // Checked once per instruction boundary, non-zero only while a device
+    // has an interrupt pending, so the run loops pay one test and branch.
+    uint8_t pending_interrupts = 0;
+    // BRK ends the run (test programs and snake end with it). When false it
+    // is a software interrupt through IRQ_VECTOR.
+    bool halt_on_brk = true;
+    // why the last step() returned false.
+    StopReason stop_reason = StopReason::Budget;
+    uint16_t fault_address = 0;
+
+    // Decoded blocks for step_cached(). The cursor is the next op of the
+    // block being run and the pc it is valid at.
+    BlockCache block_cache;
+    uint32_t block_next = 0;
+    uint8_t block_left = 0;
+    uint16_t block_pc = 0;
+
+#ifdef NES_JIT
+    // Native code for hot ROM blocks, used by run() and run_for_* once
+    // enabled. Copies of a CPU share it until one translates a block.
+    bool jit_enabled = false;
+    uint32_t jit_threshold = JIT_THRESHOLD;
+    uint64_t jit_instructions = 0; // instructions run as native code.
+    uint64_t jit_flushes = 0;      // times the full code buffer was dropped.
+    std::shared_ptr<JitBuffer> jit_buffer;
+    JitBufferOwner jit_buffer_owner;
+#endif
+
+    // Fast-forward idle loops (loops that only read RAM/ROM until a byte
+    // changes) in run() and run_for_*, which then go through the block loop.
+    bool skip_idle = false;
+    uint64_t idle_instructions = 0; // instructions skipped in idle loops.
+    // The idle block entered last and the registers and cycles it was
+    // entered with, idle_pc is 0 when the last block was not idle.
+    uint16_t idle_pc = 0;
+    uint64_t idle_registers = 0;
+    uint64_t idle_cycles = 0;
+
+#ifdef NES_LAZY_FLAGS
+    // Last values N and Z were derived from (Z = zero source is 0, N = bit 7
+    // of negative source), they only differ after BIT.
+    uint8_t lazy_zero = 1;
+    uint8_t lazy_negative = 0;
+    bool lazy_carry = false;
+    bool lazy_overflow = false;
+#endif
+
+    CPU() : register_a(0), register_x(0), register_y(0), status(STATUS_RESET), pc(0), stack_pointer(STACK_RESET), cycles(0), page_crossed(false){};
+    explicit CPU(Bus bus) : register_a(0), register_x(0), register_y(0), status(STATUS_RESET), pc(0), stack_pointer(STACK_RESET), cycles(0), bus(std::move(bus)), page_crossed(false){};
+    
+    uint8_t mem_read(uint16_t address) { return bus.mem_read(address); }
+    void mem_write(uint16_t address, uint8_t value)
+    {
+        if (!bus.mem_write(address, value))
+        {
+            this->fault_address = address;
+            this->request_stop(StopReason::BusFault);
+        }
+        // self-modifying code: drop blocks decoded from this RAM.
+        if (this->block_cache.is_code(address))
+        {
+            this->invalidate_blocks(true);
+        }
+    }
+    // Little-endian read/write.
+    uint16_t mem_read_u16(uint16_t address) { return bus.mem_read_u16(address); }
+    void mem_write_u16(uint16_t address, uint16_t value)
+    {
+        this->mem_write(address, static_cast<uint8_t>(value & 0xFF));
+        this->mem_write(address + 1, static_cast<uint8_t>(value >> 8));
+    }
+
     void reset();
+    void request_nmi() { this->pending_interrupts |= interrupts::NMI; }
+    void set_irq(bool asserted)
+    {
+        if (asserted)
+        {
+            this->pending_interrupts |= interrupts::IRQ;
+        }
+        else
+        {
+            this->pending_interrupts &= ~interrupts::IRQ;
+        }
+    }
+    // Ends the run at the next instruction boundary. Not thread-safe, call it
+    // from a callback, a device or between runs.
+    void request_stop(StopReason reason = StopReason::HostRequest)
+    {
+        this->stop_reason = reason;
+        this->pending_interrupts |= interrupts::STOP;
+    }
+    // A CPU in the same state whose RAM stays shared with this one, page by
+    // page, until either writes it. Decoded blocks are not carried over.
+    CPU fork();
     void load_and_run(std::vector<uint8_t> program);
     void load(std::vector<uint8_t> program);
-    void run();
-    void run_with_callback(std::function<void(CPU&)> callback);
+    // Until something other than a budget stops the CPU.
+    StopReason run();
+    StopReason run_with_callback(std::function<void(CPU &)> callback);
+
+    // Registers and RAM as a SaveState, the cartridge only by hash.
+    SaveState save_state() const;
+    // Returns false and leaves the CPU as is if the state is from another
+    // format version or cartridge.
+    bool load_state(const SaveState &state);
+
+    // Batched execution without a per-instruction callback. Both return
+    // StopReason::Budget unless the program stopped before the budget ran out.
+    StopReason run_for_instructions(uint64_t count);
+    // Runs whole instructions until at least `budget` cycles have elapsed.
+    StopReason run_for_cycles(uint64_t budget);
+    // Same, adding the instructions completed to `instructions` (a BRK or JAM
+    // the program stops on is not counted, like a failed step()).
+    StopReason run_for_instructions(uint64_t count, uint64_t &instructions);
+    StopReason run_for_cycles(uint64_t budget, uint64_t &instructions);
+
+    // Calls callback(cpu) before every instruction, the callable is inlined
+    // into the loop (tracing builds).
+    template <typename F>
+    StopReason run_with(F &&callback);
+    // Runs until stop(cpu) returns true (StopReason::Budget) or the program
+    // stops. The batched APIs above go through it.
+    template <typename F>
+    StopReason run_until(F &&stop);
+    // Same, through the block loop with claim (see below) when blocks are in
+    // use (NES_BLOCK_CACHE, cpu.jit_enabled or cpu.skip_idle).
+    template <typename F, typename G>
+    StopReason run_until(F &&stop, G &&claim);
+    // run_until() over whole decoded blocks, used with NES_BLOCK_CACHE.
+    template <typename F>
+    StopReason run_blocks_until(F &&stop);
+    // Same, running translated blocks and fused runs (src/fusion.h) when
+    // claim(cpu, count, prefix_cycles) allows it. They run `count`
+    // instructions without calling stop(), the ones before the last taking at
+    // most prefix_cycles, so claim must only return true if stop() would stay
+    // false for all of them, and account for them. A stop or interrupt
+    // raised inside is seen at their end. A skipped idle loop (skip_idle)
+    // claims many iterations at once, so count is not bounded by a block.
+    template <typename F, typename G>
+    StopReason run_blocks_until(F &&stop, G &&claim);
+
+    // Execute one instruction, false if the CPU stopped (see stop_reason).
+    // Only step() checks pending_interrupts, the others are the bare cores it
+    // dispatches to. step() uses the core
+    // selected at build time (NES_BLOCK_CACHE, NES_THREADED_DISPATCH), all
+    // stay callable.
+    bool step();
+    bool step_switch();
+    bool step_threaded();
+    // Runs the next op of the current decoded block, decoding on a miss.
+    bool step_cached();
+    // Drops decoded blocks, only those decoded from RAM if ram_only. Needed
+    // after writing code through cpu.bus directly instead of mem_write().
+    void invalidate_blocks(bool ram_only = false);
+
+    // Slow path of the run loops' pending_interrupts check: enters the
+    // pending NMI, or IRQ unless I is set. False if a stop was requested.
+    bool poll_interrupts();
+
+    // Full processor status, N/Z/C/V materialized when flags are lazy.
+    uint8_t get_status() const;
+    // A, X, Y, status and stack pointer packed for comparing.
+    uint64_t packed_registers() const
+    {
+        return static_cast<uint64_t>(this->register_a) | static_cast<uint64_t>(this->register_x) << 8 |
+               static_cast<uint64_t>(this->register_y) << 16 | static_cast<uint64_t>(this->get_status()) << 24 |
+               static_cast<uint64_t>(this->stack_pointer) << 32;
+    }
+    void set_status(uint8_t value);
 
     /* ------ HELPERS ------ */
+    BlockCache::Block *decode_block(uint16_t start);
+#ifdef NES_JIT
+    void jit_compile_block(BlockCache::Block &block);
+#endif
     void set_zero_and_negative_flags(uint8_t register_value);
+    // BIT: Z from one value, N from another.
+    void set_zero_and_negative_flags(uint8_t zero_source, uint8_t negative_source);
+    void set_carry_flag(bool value);
+    void set_overflow_flag(bool value);
+    bool carry_flag() const;
+    bool zero_flag() const;
+    bool negative_flag() const;
+    bool overflow_flag() const;
     bool check_status_flag();
     void add_to_register_a(uint8_t val);
     void set_register_a(uint8_t val);
@@ -59,60 +274,477 @@ struct CPU
     uint8_t stack_pop();
     void stack_push_u16(uint16_t val);
     uint16_t stack_pop_u16();
+    // Pushes pc and status (B as given) and jumps through vector with I set.
+    void interrupt(uint16_t vector, bool brk);
 
     /* --------------------- */
-    void lda(AddressingMode mode);
+    template <AddressingMode mode>
+    void lda();
     void tax();
     void inx();
-    void sta(AddressingMode mode);
+    template <AddressingMode mode>
+    void sta();
 
-    void adc(AddressingMode mode);
-    void and_op(AddressingMode mode);
+    template <AddressingMode mode>
+    void adc();
+    template <AddressingMode mode>
+    void and_op();
     void asl_acc();
-    uint8_t asl(AddressingMode mode);
+    template <AddressingMode mode>
+    uint8_t asl();
 
     // All jump related instructions.
     void branch(bool cond); // branch if cond is true
-    void bit(AddressingMode mode);
+    template <AddressingMode mode>
+    void bit();
 
     // CMP, CPX, CPY
-    void cmp_op(AddressingMode mode, uint8_t reg);
+    template <AddressingMode mode>
+    void cmp_op(uint8_t reg);
 
-    uint8_t dec(AddressingMode mode);
+    template <AddressingMode mode>
+    uint8_t dec();
     void dex(); // might not be needed, just implied op
     void dey(); // might not be needed, just implied op
-    void eor(AddressingMode mode);
-    uint8_t inc(AddressingMode mode);
+    template <AddressingMode mode>
+    void eor();
+    template <AddressingMode mode>
+    uint8_t inc();
     void iny();
 
     void jmp();
     void jmp_abs();
     void jsr();
-    void ldx(AddressingMode mode);
-    void ldy(AddressingMode mode);
+    template <AddressingMode mode>
+    void ldx();
+    template <AddressingMode mode>
+    void ldy();
     void lsr_acc();
-    uint8_t lsr(AddressingMode mode);
-    void ora(AddressingMode mode);
+    template <AddressingMode mode>
+    uint8_t lsr();
+    template <AddressingMode mode>
+    void ora();
     void pha();
     void php();
+    void brk();
     void pla();
     void plp();
     void rol_acc();
-    uint8_t rol(AddressingMode mode);
+    template <AddressingMode mode>
+    uint8_t rol();
     void ror_acc();
-    uint8_t ror(AddressingMode mode);
+    template <AddressingMode mode>
+    uint8_t ror();
     void rti();
     void rts();
-    void sbc(AddressingMode mode);
-    void stx(AddressingMode mode);
-    void sty(AddressingMode mode);
+    template <AddressingMode mode>
+    void sbc();
+    template <AddressingMode mode>
+    void stx();
+    template <AddressingMode mode>
+    void sty();
     void tay();
     void tsx();
     void txa();
     void txs();
     void tya();
 
-    uint16_t get_operand_address(AddressingMode mode);
+    // Undocumented opcodes that aren't two documented ones in a row.
+    void compare(uint8_t reg, uint8_t val);
+    template <AddressingMode mode>
+    uint8_t read_operand();
+    template <AddressingMode mode>
+    void sax();
+    template <AddressingMode mode>
+    void axs();
+    template <AddressingMode mode>
+    void las();
+    template <AddressingMode mode>
+    void store_and_high(uint8_t val);
+
+    template <AddressingMode mode>
+    uint16_t get_operand_address();
+    template <AddressingMode mode>
+    uint16_t get_abs_address(uint16_t addr);
+    uint16_t get_abs_address(AddressingMode mode, uint16_t addr);
+};
+
+#ifdef NES_LAZY_FLAGS
+// Lazy flags: instructions only store the value a flag comes from, the
+// compare against 0 / bit test happens when a branch, PHP or get_status()
+// reads the flag.
+inline uint8_t CPU::get_status() const
+{
+    uint8_t status = this->status & ~(cpu_flags::NEGATIVE | cpu_flags::OVERFLW | cpu_flags::ZERO | cpu_flags::CARRY);
+    status |= this->lazy_negative & cpu_flags::NEGATIVE;
+    status |= this->lazy_zero == 0 ? cpu_flags::ZERO : 0;
+    status |= this->lazy_overflow ? cpu_flags::OVERFLW : 0;
+    status |= this->lazy_carry ? cpu_flags::CARRY : 0;
+    return status;
+}
+
+inline void CPU::set_status(uint8_t value)
+{
+    this->status = value;
+    this->lazy_negative = value;
+    this->lazy_zero = (value & cpu_flags::ZERO) ^ cpu_flags::ZERO;
+    this->lazy_overflow = (value & cpu_flags::OVERFLW) != 0;
+    this->lazy_carry = (value & cpu_flags::CARRY) != 0;
+}
+
+inline void CPU::set_zero_and_negative_flags(uint8_t register_value)
+{
+    this->lazy_zero = register_value;
+    this->lazy_negative = register_value;
+}
+
+inline void CPU::set_zero_and_negative_flags(uint8_t zero_source, uint8_t negative_source)
+{
+    this->lazy_zero = zero_source;
+    this->lazy_negative = negative_source;
+}
+
+inline void CPU::set_carry_flag(bool value) { this->lazy_carry = value; }
+inline void CPU::set_overflow_flag(bool value) { this->lazy_overflow = value; }
+inline bool CPU::carry_flag() const { return this->lazy_carry; }
+inline bool CPU::zero_flag() const { return this->lazy_zero == 0; }
+inline bool CPU::negative_flag() const { return (this->lazy_negative & cpu_flags::NEGATIVE) != 0; }
+inline bool CPU::overflow_flag() const { return this->lazy_overflow; }
+#else
+inline uint8_t CPU::get_status() const { return this->status; }
+inline void CPU::set_status(uint8_t value) { this->status = value; }
+
+inline void CPU::set_zero_and_negative_flags(uint8_t register_value)
+{
+    this->set_zero_and_negative_flags(register_value, register_value);
+}
+
+inline void CPU::set_zero_and_negative_flags(uint8_t zero_source, uint8_t negative_source)
+{
+    if (zero_source == 0)
+    {
+        this->status |= cpu_flags::ZERO;
+    }
+    else
+    {
+        this->status &= ~cpu_flags::ZERO;
+    }
+
+    if ((negative_source >> 7) == 1)
+    {
+        this->status |= cpu_flags::NEGATIVE;
+    }
+    else
+    {
+        this->status &= ~cpu_flags::NEGATIVE;
+    }
+}
+
+inline void CPU::set_carry_flag(bool value)
+{
+    if (value)
+    {
+        this->status |= cpu_flags::CARRY;
+    }
+    else
+    {
+        this->status &= ~cpu_flags::CARRY;
+    }
+}
+
+inline void CPU::set_overflow_flag(bool value)
+{
+    if (value)
+    {
+        this->status |= cpu_flags::OVERFLW;
+    }
+    else
+    {
+        this->status &= ~cpu_flags::OVERFLW;
+    }
+}
+
+inline bool CPU::carry_flag() const { return (this->status & cpu_flags::CARRY) != 0; }
+inline bool CPU::zero_flag() const { return (this->status & cpu_flags::ZERO) != 0; }
+inline bool CPU::negative_flag() const { return (this->status & cpu_flags::NEGATIVE) != 0; }
+inline bool CPU::overflow_flag() const { return (this->status & cpu_flags::OVERFLW) != 0; }
+#endif
+
+template <typename F>
+StopReason CPU::run_with(F &&callback)
+{
+    while (true)
+    {
+        callback(*this);
+
+        if (!this->step())
+        {
+            return this->stop_reason;
+        }
+    }
+}
+
+template <typename F>
+StopReason CPU::run_until(F &&stop)
+{
+#ifdef NES_BLOCK_CACHE
+    return this->run_blocks_until(stop);
+#else
+    // interrupts are entered before stop() is asked, as in the block loop.
+    while (true)
+    {
+        if (this->pending_interrupts != 0 && !this->poll_interrupts())
+        {
+            return this->stop_reason;
+        }
+        if (stop(*this))
+        {
+            return StopReason::Budget;
+        }
+#ifdef NES_THREADED_DISPATCH
+        if (!this->step_threaded())
+#else
+        if (!this->step_switch())
+#endif
+        {
+            return this->stop_reason;
+        }
+    }
+#endif
+}
+
+template <typename F, typename G>
+StopReason CPU::run_until(F &&stop, [[maybe_unused]] G &&claim)
+{
+#ifdef NES_BLOCK_CACHE
+    return this->run_blocks_until(stop, claim);
+#else
+    bool blocks = this->skip_idle;
+#ifdef NES_JIT
+    blocks = blocks || this->jit_enabled;
+#endif
+    if (blocks)
+    {
+        return this->run_blocks_until(stop, claim);
+    }
+    return this->run_until(stop);
+#endif
+}
+
+// claim for run_blocks_until() that never runs native code or fused runs.
+struct NoNative
+{
+    bool operator()(CPU &, uint64_t, uint64_t) const { return false; }
 };
 
+template <typename F>
+StopReason CPU::run_blocks_until(F &&stop)
+{
+    return this->run_blocks_until(stop, NoNative{});
+}
+
+// Looks each block up once and runs its ops back to back, between them only
+// stop() and a write dropping RAM blocks (mem_write clears block_left) are
+// checked.
+template <typename F, typename G>
+StopReason CPU::run_blocks_until(F &&stop, [[maybe_unused]] G &&claim)
+{
+    // RAM may have changed since the last run.
+    this->idle_pc = 0;
+    while (true)
+    {
+        if (this->pending_interrupts != 0 && !this->poll_interrupts())
+        {
+            return this->stop_reason;
+        }
+        BlockCache::Block *block = this->block_cache.find(this->pc);
+        if (block == nullptr)
+        {
+            block = this->decode_block(this->pc);
+        }
+        if (block == nullptr)
+        {
+            if (stop(*this))
+            {
+                return StopReason::Budget;
+            }
+            this->idle_pc = 0;
+            if (!this->step_threaded())
+            {
+                return this->stop_reason;
+            }
+            continue;
+        }
+
+        if constexpr (!std::is_same<std::decay_t<G>, NoNative>::value)
+        {
+            // An idle block writes nothing and only exits by not branching
+            // back. Entered twice in a row with the same registers it reads
+            // the same bytes and repeats its last iteration until an
+            // interrupt, so claimed iterations just add that one's cycles.
+            if (this->skip_idle && block->idle)
+            {
+                uint64_t registers = this->packed_registers();
+                if (this->idle_pc == block->start && this->idle_registers == registers)
+                {
+                    // Offers each power of two iterations once, largest
+                    // first, which claims the most that fit in at most 33
+                    // claims. Longer waits take more passes, so an
+                    // always-true claim (run()) still gets back to stop()
+                    // and interrupts, and cycles never wrap.
+                    uint64_t iteration = this->cycles - this->idle_cycles;
+                    for (uint64_t repeats = uint64_t(1) << 32; repeats != 0 && this->pending_interrupts == 0; repeats /= 2)
+                    {
+                        if (repeats * iteration <= UINT64_MAX - this->cycles &&
+                            claim(*this, repeats * block->count, (repeats - 1) * iteration + block->prefix_cycles))
+                        {
+                            this->cycles += repeats * iteration;
+                            this->idle_instructions += repeats * block->count;
+                        }
+                    }
+                }
+                this->idle_pc = block->start;
+                this->idle_registers = registers;
+                this->idle_cycles = this->cycles;
+            }
+            else
+            {
+                this->idle_pc = 0;
+            }
+        }
+
+#ifdef NES_JIT
+        if constexpr (!std::is_same<std::decay_t<G>, NoNative>::value)
+        {
+            if (this->jit_enabled)
+            {
+                // only ROM blocks, RAM code may be rewritten under them.
+                if (block->native == nullptr && block->start > RAM_END && ++block->hits == this->jit_threshold)
+                {
+                    this->jit_compile_block(*block);
+                }
+                if (block->native != nullptr && claim(*this, block->count, block->prefix_cycles))
+                {
+                    block->native(this);
+                    this->jit_instructions += block->count;
+                    continue;
+                }
+            }
+        }
+#endif
+
+        const DecodedOp *op = &this->block_cache.ops[block->first];
+        const DecodedOp *end = op + block->count;
+        this->block_left = 1;
+        do
+        {
+            OpHandler handler = op->handler;
+            bool fused = false;
+            if constexpr (!std::is_same<std::decay_t<G>, NoNative>::value)
+            {
+                fused = op->fused != nullptr && claim(*this, op->fused_count, op->fused_prefix_cycles);
+            }
+            if (fused)
+            {
+                handler = op->fused;
+                op += op->fused_count - 1;
+            }
+            else if (stop(*this))
+            {
+                this->block_left = 0;
+                return StopReason::Budget;
+            }
+            this->pc++;
+            if (!handler(*this))
+            {
+                this->block_left = 0;
+                return this->stop_reason;
+            }
+            // an interrupt taken here clears block_left, the outer loop
+            // looks up the handler's block.
+            if (this->pending_interrupts != 0 && !this->poll_interrupts())
+            {
+                this->block_left = 0;
+                return this->stop_reason;
+            }
+        } while (++op != end && this->block_left != 0);
+        this->block_left = 0;
+    }
+}
+
+// Operand resolution with the addressing mode fixed at compile time, the
+// instruction handlers instantiate one of these per opcode.
+template <AddressingMode mode>
+uint16_t CPU::get_operand_address()
+{
+    if constexpr (mode == AddressingMode::Immediate)
+    {
+        return this->pc;
+    }
+    else
+    {
+        return this->get_abs_address<mode>(this->pc);
+    }
+}
+
+template <AddressingMode mode>
+uint16_t CPU::get_abs_address(uint16_t begin)
+{
+    if constexpr (mode == AddressingMode::ZeroPage)
+    {
+        return static_cast<uint16_t>(this->mem_read(begin));
+    }
+    else if constexpr (mode == AddressingMode::Absolute)
+    {
+        return this->mem_read_u16(begin);
+    }
+    else if constexpr (mode == AddressingMode::ZeroPageX)
+    {
+        uint8_t pos = this->mem_read(begin);
+        // wraps within the zero page.
+        uint16_t addr = static_cast<uint8_t>(pos + this->register_x);
+        return addr;
+    }
+    else if constexpr (mode == AddressingMode::ZeroPageY)
+    {
+        uint8_t pos = this->mem_read(begin);
+        // wraps within the zero page.
+        uint16_t addr = static_cast<uint8_t>(pos + this->register_y);
+        return addr;
+    }
+    else if constexpr (mode == AddressingMode::AbsoluteX)
+    {
+        uint16_t base = this->mem_read_u16(begin);
+        uint16_t addr = base + this->register_x;
+        this->page_crossed = (base & 0xFF00) != (addr & 0xFF00);
+        return addr;
+    }
+    else if constexpr (mode == AddressingMode::AbsoluteY)
+    {
+        uint16_t base = this->mem_read_u16(begin);
+        uint16_t addr = base + this->register_y;
+        this->page_crossed = (base & 0xFF00) != (addr & 0xFF00);
+        return addr;
+    }
+    else if constexpr (mode == AddressingMode::IndirectX)
+    {
+        uint8_t base = this->mem_read(begin);
+        uint8_t ptr = base + this->register_x;
+        uint16_t lo = this->mem_read(static_cast<uint16_t>(ptr));
+        uint16_t hi = this->mem_read(static_cast<uint8_t>(ptr + 1));
+        return (hi << 8) | lo;
+    }
+    else
+    {
+        static_assert(mode == AddressingMode::IndirectY, "addressing mode has no operand address");
+        uint8_t base = this->mem_read(begin);
+        uint16_t lo = this->mem_read(static_cast<uint16_t>(base));
+        uint16_t hi = this->mem_read(static_cast<uint8_t>(base + 1));
+        uint16_t deref_base = (hi << 8) | lo;
+        uint16_t deref = deref_base + static_cast<uint16_t>(this->register_y);
+        this->page_crossed = (deref_base & 0xFF00) != (deref & 0xFF00);
+        return deref;
+    }
+}
+
 #endif // !CPU_H
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "fleet.h"
+#include <algorithm>
+
+Fleet::Fleet(size_t threads)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threads; ++i)
+    {
+        this->workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threads; ++i)
+    {
+        this->workers[i]->thread = std::thread(&Fleet::work, this, i);
+    }
+}
+
+Fleet::~Fleet()
+{
+    {
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->stopping = true;
+    }
+    this->batch_ready.notify_all();
+    for (auto &worker : this->workers)
+    {
+        worker->thread.join();
+    }
+}
+
+size_t Fleet::add(std::shared_ptr<const Rom> rom)
+{
+    this->sessions.emplace_back(CPU(Bus(std::move(rom))));
+    this->sessions.back().cpu.reset();
+    return this->sessions.size() - 1;
+}
+
+size_t Fleet::fork(size_t id)
+{
+    Session &parent = this->sessions[id];
+    this->sessions.emplace_back(parent.cpu.fork());
+    this->sessions.back().running = parent.running;
+    this->sessions.back().stop_reason = parent.stop_reason;
+    return this->sessions.size() - 1;
+}
+
+void Fleet::run_for_cycles(uint64_t budget)
+{
+    size_t tasks = 0;
+    for (const Session &session : this->sessions)
+    {
+        tasks += session.running ? 1 : 0;
+    }
+    if (tasks == 0)
+    {
+        return;
+    }
+
+    // the batch is published before any of its ids is queued, so a worker
+    // still draining the last batch never sees a task without its budget.
+    std::unique_lock<std::mutex> guard(this->lock);
+    this->budget = budget;
+    this->pending = tasks;
+    this->batch++;
+    size_t queued = 0;
+    for (size_t id = 0; id < this->sessions.size(); ++id)
+    {
+        if (!this->sessions[id].running)
+        {
+            continue;
+        }
+        Worker &worker = *this->workers[queued % this->workers.size()];
+        std::lock_guard<std::mutex> worker_guard(worker.lock);
+        worker.queue.push_back(Task{this->batch, id});
+        queued++;
+    }
+    this->batch_ready.notify_all();
+    this->batch_done.wait(guard, [this]
+                          { return this->pending == 0; });
+}
+
+void Fleet::work(size_t index)
+{
+    uint64_t seen = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> guard(this->lock);
+            this->batch_ready.wait(guard, [&]
+                                   { return this->stopping || this->batch != seen; });
+            if (this->stopping)
+            {
+                return;
+            }
+            seen = this->batch;
+        }
+
+        size_t id;
+        while (this->next_task(index, seen, id))
+        {
+            this->run_session(this->sessions[id]);
+            if (--this->pending == 0)
+            {
+                std::lock_guard<std::mutex> guard(this->lock);
+                this->batch_done.notify_all();
+            }
+        }
+    }
+}
+
+// Own queue from the front, then steal from the back of the others. Only
+// tasks of `batch`, the one the worker woke up for, are taken.
+bool Fleet::next_task(size_t index, uint64_t batch, size_t &id)
+{
+    for (size_t i = 0; i < this->workers.size(); ++i)
+    {
+        Worker &worker = *this->workers[(index + i) % this->workers.size()];
+        std::lock_guard<std::mutex> guard(worker.lock);
+        if (worker.queue.empty())
+        {
+            continue;
+        }
+        Task &task = i == 0 ? worker.queue.front() : worker.queue.back();
+        if (task.batch != batch)
+        {
+            continue;
+        }
+        id = task.id;
+        if (i == 0)
+        {
+            worker.queue.pop_front();
+        }
+        else
+        {
+            worker.queue.pop_back();
+        }
+        return true;
+    }
+    return false;
+}
+
+void Fleet::run_session(Session &session)
+{
+    StopReason reason = session.cpu.run_for_cycles(this->budget, session.instructions);
+    if (reason != StopReason::Budget)
+    {
+        session.running = false;
+        session.stop_reason = reason;
+    }
+}
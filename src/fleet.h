@@ -0,0 +1,83 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "cpu.h"
+
+struct Session
+{
+    CPU cpu;
+    bool running = true; // false once the program stopped, see stop_reason.
+    StopReason stop_reason = StopReason::Budget;
+    uint64_t instructions = 0;
+
+    explicit Session(CPU cpu) : cpu(std::move(cpu)){};
+};
+
+// Runs many independent CPU instances on a pool of worker threads. Each
+// batch hands the running sessions out to per-worker queues, idle workers
+// steal from the back of the others' queues.
+class Fleet
+{
+public:
+    // threads == 0 uses one worker per hardware thread.
+    explicit Fleet(size_t threads = 0);
+    ~Fleet();
+    Fleet(const Fleet &) = delete;
+    Fleet &operator=(const Fleet &) = delete;
+
+    // Adds a session booting `rom` through its reset vector, the ROM data is
+    // shared, not copied. Returns the session id.
+    size_t add(std::shared_ptr<const Rom> rom);
+    // Adds a fork of session `id`, sharing its RAM until either writes it.
+    size_t fork(size_t id);
+    Session &session(size_t id) { return this->sessions[id]; }
+    size_t size() const { return this->sessions.size(); }
+    size_t threads() const { return this->workers.size(); }
+
+    // Runs every running session for `budget` cycles in parallel and
+    // returns once the whole batch is done.
+    void run_for_cycles(uint64_t budget);
+
+private:
+    // A session id and the batch it belongs to.
+    struct Task
+    {
+        uint64_t batch;
+        size_t id;
+    };
+
+    struct Worker
+    {
+        std::thread thread;
+        std::mutex lock;
+        std::deque<Task> queue;
+    };
+
+    // deque so sessions never move once added.
+    std::deque<Session> sessions;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    // batch, budget and pending are set under lock before the batch's tasks
+    // are queued.
+    std::mutex lock;
+    std::condition_variable batch_ready;
+    std::condition_variable batch_done;
+    uint64_t batch = 0;
+    uint64_t budget = 0;
+    std::atomic<size_t> pending{0};
+    bool stopping = false;
+
+    void work(size_t index);
+    bool next_task(size_t index, uint64_t batch, size_t &id);
+    void run_session(Session &session);
+};
+
+#endif // !FLEET_H
@@ -0,0 +1,64 @@
+#ifndef FUSION_H
+#define FUSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include "opcode.h"
+
+// A run of adjacent instructions executed by one fused handler
+// (superinstruction), so the compiler sees across them and the block loop
+// dispatches once.
+struct FusedOps
+{
+    uint8_t count;
+    uint8_t codes[3];
+};
+
+// Picked with trace_histogram.out from nestest traces plus the usual game
+// idioms (countdown loops, polling compares, table copies). decode_block
+// takes the first entry that matches, so longer runs come first.
+inline constexpr FusedOps FUSED_OPS[] = {
+    {3, {0xAD, 0xC9, 0xF0}}, // LDA abs / CMP #imm / BEQ
+    {3, {0xA5, 0xC9, 0xF0}}, // LDA zp / CMP #imm / BEQ
+    {3, {0xA5, 0xC9, 0xD0}}, // LDA zp / CMP #imm / BNE
+    {2, {0xC9, 0xD0}},       // CMP #imm / BNE
+    {2, {0xC9, 0xF0}},       // CMP #imm / BEQ
+    {2, {0xE0, 0xD0}},       // CPX #imm / BNE
+    {2, {0xC0, 0xD0}},       // CPY #imm / BNE
+    {2, {0xCA, 0xD0}},       // DEX / BNE
+    {2, {0x88, 0xD0}},       // DEY / BNE
+    {2, {0xE8, 0xD0}},       // INX / BNE
+    {2, {0xC8, 0xD0}},       // INY / BNE
+    {2, {0xE6, 0xD0}},       // INC zp / BNE
+    {2, {0xA9, 0x8D}},       // LDA #imm / STA abs
+    {2, {0xA9, 0x85}},       // LDA #imm / STA zp
+    {2, {0xA5, 0x85}},       // LDA zp / STA zp
+    {2, {0xAD, 0x8D}},       // LDA abs / STA abs
+    {2, {0xB1, 0x9D}},       // LDA (zp),Y / STA abs,X
+    {2, {0xB9, 0x99}},       // LDA abs,Y / STA abs,Y
+    {2, {0xA9, 0x60}},       // LDA #imm / RTS
+};
+inline constexpr size_t FUSED_OPS_COUNT = sizeof(FUSED_OPS) / sizeof(FUSED_OPS[0]);
+
+// Only the last op of a run may leave straight-line flow.
+constexpr bool fused_ops_valid()
+{
+    for (const FusedOps &fused : FUSED_OPS)
+    {
+        if (fused.count < 2 || fused.count > 3)
+        {
+            return false;
+        }
+        for (size_t i = 0; i + 1 < fused.count; ++i)
+        {
+            if (ends_block(OP_CODES[fused.codes[i]]))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+static_assert(fused_ops_valid(), "a fused run can only end in a jump, branch, BRK or JAM");
+
+#endif // !FUSION_H
@@ -1,6 +1,8 @@
 #ifndef GLOBAL_H
 #define GLOBAL_H
 
+#include <cstdint>
+
 enum AddressingMode
 {
     Immediate,
@@ -15,4 +17,71 @@ enum AddressingMode
     NoneAddressing,
 };
 
+// Statically dispatched memory interface (CRTP): Derived provides
+// mem_read/mem_write and the u16 helpers inline into the caller.
+template <typename Derived>
+class Mem
+{
+public:
+    uint16_t mem_read_u16(uint16_t pos)
+    {
+        uint16_t lo = static_cast<uint16_t>(derived().mem_read(pos));
+        uint16_t hi = static_cast<uint16_t>(derived().mem_read(pos + 1));
+        return (hi << 8) | lo;
+    }
+
+    void mem_write_u16(uint16_t pos, uint16_t data)
+    {
+        uint8_t hi = static_cast<uint8_t>(data >> 8);
+        uint8_t lo = static_cast<uint8_t>(data & 0xFF);
+        derived().mem_write(pos, lo);
+        derived().mem_write(pos + 1, hi);
+    }
+
+private:
+    Derived &derived() { return static_cast<Derived &>(*this); }
+};
+
+// Virtual memory interface for code that wants runtime polymorphism,
+// e.g. tests mocking memory. Not used on the CPU -> Bus path.
+class VirtualMem
+{
+public:
+    virtual ~VirtualMem() = default;
+
+    virtual uint8_t mem_read(uint16_t address) = 0;
+    virtual void mem_write(uint16_t address, uint8_t value) = 0;
+
+    virtual uint16_t mem_read_u16(uint16_t pos)
+    {
+        uint16_t lo = static_cast<uint16_t>(mem_read(pos));
+        uint16_t hi = static_cast<uint16_t>(mem_read(pos + 1));
+        return (hi << 8) | lo;
+    }
+
+    virtual void mem_write_u16(uint16_t pos, uint16_t data)
+    {
+        uint8_t hi = static_cast<uint8_t>(data >> 8);
+        uint8_t lo = static_cast<uint8_t>(data & 0xFF);
+        mem_write(pos, lo);
+        mem_write(pos + 1, hi);
+    }
+};
+
+// Exposes any Mem<T> (Bus, CPU) through VirtualMem.
+template <typename T>
+class MemAdapter : public VirtualMem
+{
+public:
+    explicit MemAdapter(T &mem) : mem(mem) {}
+
+    uint8_t mem_read(uint16_t address) override { return mem.mem_read(address); }
+    void mem_write(uint16_t address, uint8_t value) override { mem.mem_write(address, value); }
+    uint16_t mem_read_u16(uint16_t pos) override { return mem.mem_read_u16(pos); }
+    void mem_write_u16(uint16_t pos, uint16_t data) override { mem.mem_write_u16(pos, data); }
+
+private:
+    T &mem;
+};
+
 #endif // !GLOBAL_H
\ No newline at end of file
@@ -0,0 +1,805 @@
+#include "jit.h"
+#include <cstring>
+#include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+#include "cpu.h"
+
+JitBuffer::JitBuffer(size_t size) : code(nullptr), size(0)
+{
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "No executable memory, JIT disabled" << std::endl;
+        return;
+    }
+    this->code = static_cast<uint8_t *>(mapping);
+    this->size = size;
+}
+
+JitBuffer::~JitBuffer()
+{
+    if (this->code != nullptr)
+    {
+        munmap(this->code, this->size);
+    }
+}
+
+uint8_t *JitBuffer::append(const uint8_t *bytes, size_t count)
+{
+    if (this->code == nullptr)
+    {
+        return nullptr;
+    }
+    if (this->used + count > this->size)
+    {
+        this->full = true;
+        return nullptr;
+    }
+    // from the page holding the end of the last block on.
+    static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    uint8_t *pages = this->code + this->used / page_size * page_size;
+    size_t length = this->code + this->used + count - pages;
+    if (mprotect(pages, length, PROT_READ | PROT_WRITE) != 0)
+    {
+        return nullptr;
+    }
+    uint8_t *start = this->code + this->used;
+    std::memcpy(start, bytes, count);
+    if (mprotect(pages, length, PROT_READ | PROT_EXEC) != 0)
+    {
+        std::cerr << "Failed to make JIT code executable" << std::endl;
+        exit(1);
+    }
+    this->used += count;
+    return start;
+}
+
+void JitBuffer::clear()
+{
+    if (this->code != nullptr && mprotect(this->code, this->size, PROT_READ | PROT_WRITE) != 0)
+    {
+        std::cerr << "Failed to reset JIT code" << std::endl;
+        exit(1);
+    }
+    this->used = 0;
+    this->full = false;
+}
+
+namespace
+{
+    // Offsets of the CPU fields generated code touches, rbx holds the CPU.
+    struct Fields
+    {
+        int32_t a, x, y, sp, status, pc, cycles, read_map, write_map, code_pages;
+#ifdef NES_LAZY_FLAGS
+        int32_t zero, negative, carry, overflow;
+#endif
+    };
+
+    int32_t offset(const CPU &cpu, const void *field)
+    {
+        return static_cast<int32_t>(static_cast<const uint8_t *>(field) - reinterpret_cast<const uint8_t *>(&cpu));
+    }
+
+    Fields fields(const CPU &cpu)
+    {
+        Fields f;
+        f.a = offset(cpu, &cpu.register_a);
+        f.x = offset(cpu, &cpu.register_x);
+        f.y = offset(cpu, &cpu.register_y);
+        f.sp = offset(cpu, &cpu.stack_pointer);
+        f.status = offset(cpu, &cpu.status);
+        f.pc = offset(cpu, &cpu.pc);
+        f.cycles = offset(cpu, &cpu.cycles);
+        f.read_map = offset(cpu, cpu.bus.read_map());
+        f.write_map = offset(cpu, cpu.bus.write_map());
+        f.code_pages = offset(cpu, cpu.block_cache.code_pages);
+#ifdef NES_LAZY_FLAGS
+        f.zero = offset(cpu, &cpu.lazy_zero);
+        f.negative = offset(cpu, &cpu.lazy_negative);
+        f.carry = offset(cpu, &cpu.lazy_carry);
+        f.overflow = offset(cpu, &cpu.lazy_overflow);
+#endif
+        return f;
+    }
+
+    // x86 byte registers, as encoded in ModRM.
+    enum Reg : uint8_t
+    {
+        AL = 0,
+        CL = 1,
+        DL = 2,
+    };
+
+    // condition codes of jcc/setcc, a code with bit 0 flipped is its inverse.
+    enum Cond : uint8_t
+    {
+        CC_O = 0x0,
+        CC_B = 0x2,
+        CC_AE = 0x3,
+        CC_E = 0x4,
+        CC_NE = 0x5,
+    };
+
+    // ALU opcodes of the "op r/m8, r8" form, used as op al, cl.
+    const uint8_t X86_ADC = 0x10;
+    const uint8_t X86_AND = 0x20;
+    const uint8_t X86_OR = 0x08;
+    const uint8_t X86_XOR = 0x30;
+    const uint8_t X86_SUB = 0x28;
+    const uint8_t X86_SBB = 0x18;
+
+    // Just the instruction forms the translator needs. Memory operands are
+    // [rbx + disp32] for CPU fields, and [rdx + disp32] or [rdx + rax] for
+    // the RAM page rdx was loaded with.
+    struct Emitter
+    {
+        std::vector<uint8_t> code;
+
+        void byte(uint8_t value) { this->code.push_back(value); }
+        void imm16(uint16_t value)
+        {
+            this->byte(static_cast<uint8_t>(value));
+            this->byte(static_cast<uint8_t>(value >> 8));
+        }
+        void imm32(uint32_t value)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                this->byte(static_cast<uint8_t>(value >> (i * 8)));
+            }
+        }
+        void imm64(uint64_t value)
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                this->byte(static_cast<uint8_t>(value >> (i * 8)));
+            }
+        }
+        // ModRM for [rbx + disp32].
+        void rbx(uint8_t reg, int32_t disp)
+        {
+            this->byte(0x80 | (reg << 3) | 0x03);
+            this->imm32(static_cast<uint32_t>(disp));
+        }
+        // ModRM for [rdx + disp32].
+        void rdx(uint8_t reg, int32_t disp)
+        {
+            this->byte(0x80 | (reg << 3) | 0x02);
+            this->imm32(static_cast<uint32_t>(disp));
+        }
+        // ModRM + SIB for [rdx + rax].
+        void rdx_rax(uint8_t reg)
+        {
+            this->byte(0x04 | (reg << 3));
+            this->byte(0x02);
+        }
+
+        void load8(Reg reg, int32_t disp)
+        {
+            this->byte(0x8A);
+            this->rbx(reg, disp);
+        }
+        void store8(int32_t disp, Reg reg)
+        {
+            this->byte(0x88);
+            this->rbx(reg, disp);
+        }
+        // mov rdx, [rbx + disp]
+        void load_page(int32_t disp)
+        {
+            this->byte(0x48);
+            this->byte(0x8B);
+            this->rbx(DL, disp);
+        }
+        void load8_page(Reg reg, uint8_t offset)
+        {
+            this->byte(0x8A);
+            this->rdx(reg, offset);
+        }
+        void store8_page(uint8_t offset, Reg reg)
+        {
+            this->byte(0x88);
+            this->rdx(reg, offset);
+        }
+        void load8_page_indexed(Reg reg)
+        {
+            this->byte(0x8A);
+            this->rdx_rax(reg);
+        }
+        void store8_page_indexed(Reg reg)
+        {
+            this->byte(0x88);
+            this->rdx_rax(reg);
+        }
+        void inc8_page(uint8_t offset)
+        {
+            this->byte(0xFE);
+            this->rdx(0, offset);
+        }
+        void dec8_page(uint8_t offset)
+        {
+            this->byte(0xFE);
+            this->rdx(1, offset);
+        }
+        // cmp qword [rbx + disp], 0
+        void cmp_null(int32_t disp)
+        {
+            this->byte(0x48);
+            this->byte(0x83);
+            this->rbx(7, disp);
+            this->byte(0);
+        }
+        // movzx eax, byte [rbx + disp]
+        void load_index(int32_t disp)
+        {
+            this->byte(0x0F);
+            this->byte(0xB6);
+            this->rbx(AL, disp);
+        }
+        void store_imm8(int32_t disp, uint8_t value)
+        {
+            this->byte(0xC6);
+            this->rbx(0, disp);
+            this->byte(value);
+        }
+        void store_imm16(int32_t disp, uint16_t value)
+        {
+            this->byte(0x66);
+            this->byte(0xC7);
+            this->rbx(0, disp);
+            this->imm16(value);
+        }
+        void add64_imm(int32_t disp, uint32_t value)
+        {
+            this->byte(0x48);
+            this->byte(0x81);
+            this->rbx(0, disp);
+            this->imm32(value);
+        }
+        void mov_cl_imm(uint8_t value)
+        {
+            this->byte(0xB1);
+            this->byte(value);
+        }
+        void add_al_imm(uint8_t value)
+        {
+            this->byte(0x04);
+            this->byte(value);
+        }
+        void alu_al_cl(uint8_t op)
+        {
+            this->byte(op);
+            this->byte(0xC8);
+        }
+        void setcc(Cond cond, int32_t disp)
+        {
+            this->byte(0x0F);
+            this->byte(0x90 | cond);
+            this->rbx(0, disp);
+        }
+        void cmp_imm8(int32_t disp, uint8_t value)
+        {
+            this->byte(0x80);
+            this->rbx(7, disp);
+            this->byte(value);
+        }
+        void test_imm8(int32_t disp, uint8_t value)
+        {
+            this->byte(0xF6);
+            this->rbx(0, disp);
+            this->byte(value);
+        }
+        void and_imm8(int32_t disp, uint8_t value)
+        {
+            this->byte(0x80);
+            this->rbx(4, disp);
+            this->byte(value);
+        }
+        void or_imm8(int32_t disp, uint8_t value)
+        {
+            this->byte(0x80);
+            this->rbx(1, disp);
+            this->byte(value);
+        }
+        void inc8(int32_t disp)
+        {
+            this->byte(0xFE);
+            this->rbx(0, disp);
+        }
+        void dec8(int32_t disp)
+        {
+            this->byte(0xFE);
+            this->rbx(1, disp);
+        }
+        // handler(cpu), the CPU stays in rbx (callee saved).
+        void call(const void *function)
+        {
+            this->byte(0x48); // mov rdi, rbx
+            this->byte(0x89);
+            this->byte(0xDF);
+            this->byte(0x48); // mov rax, imm64
+            this->byte(0xB8);
+            this->imm64(reinterpret_cast<uint64_t>(function));
+            this->byte(0xFF); // call rax
+            this->byte(0xD0);
+        }
+        // function(cpu, arg)
+        void call(const void *function, uint32_t arg)
+        {
+            this->byte(0xBE); // mov esi, imm32
+            this->imm32(arg);
+            this->call(function);
+        }
+        void prologue()
+        {
+            this->byte(0x53); // push rbx, also aligns the stack for calls.
+            this->byte(0x48); // mov rbx, rdi
+            this->byte(0x89);
+            this->byte(0xFB);
+        }
+        void epilogue()
+        {
+            this->byte(0x5B); // pop rbx
+            this->byte(0xC3); // ret
+        }
+        // short forward jcc, returns the position to patch().
+        size_t jcc8(Cond cond)
+        {
+            this->byte(0x70 | cond);
+            this->byte(0);
+            return this->code.size();
+        }
+        void patch(size_t at) { this->code[at - 1] = static_cast<uint8_t>(this->code.size() - at); }
+    };
+
+    void invalidate_ram(CPU *cpu)
+    {
+        cpu->invalidate_blocks(true);
+    }
+
+    void unshare_ram(CPU *cpu, uint32_t address)
+    {
+        cpu->bus.unshare(static_cast<uint16_t>(address));
+    }
+
+    struct Translator
+    {
+        CPU &cpu;
+        Fields f;
+        Emitter e;
+
+        // Operand value into cl. False if it is not in RAM or ROM.
+        bool load_operand(AddressingMode mode, uint8_t lo, uint8_t hi)
+        {
+            uint16_t addr = static_cast<uint16_t>(hi) << 8 | lo;
+            switch (mode)
+            {
+            case AddressingMode::Immediate:
+                this->e.mov_cl_imm(lo);
+                return true;
+            case AddressingMode::ZeroPage:
+                this->e.load_page(this->f.read_map);
+                this->e.load8_page(CL, lo);
+                return true;
+            case AddressingMode::ZeroPageX:
+            case AddressingMode::ZeroPageY:
+                this->e.load_index(mode == AddressingMode::ZeroPageX ? this->f.x : this->f.y);
+                this->e.add_al_imm(lo);
+                this->e.load_page(this->f.read_map);
+                this->e.load8_page_indexed(CL);
+                return true;
+            case AddressingMode::Absolute:
+                if (addr <= RAM_END)
+                {
+                    this->e.load_page(this->f.read_map + (addr >> 8) * sizeof(void *));
+                    this->e.load8_page(CL, lo);
+                    return true;
+                }
+                if (addr >= PRG_ROM && this->cpu.bus.is_mapped(addr))
+                {
+                    // ROM does not change under a translated block.
+                    this->e.mov_cl_imm(this->cpu.bus.peek(addr));
+                    return true;
+                }
+                return false;
+            default:
+                return false;
+            }
+        }
+
+        // Drops RAM blocks if the write hit a page holding cached code.
+        void check_code_page(uint8_t page)
+        {
+            this->e.cmp_imm8(this->f.code_pages + page, 0);
+            size_t skip = this->e.jcc8(CC_E);
+            this->e.call(reinterpret_cast<const void *>(&invalidate_ram));
+            this->e.patch(skip);
+        }
+
+        // rdx = RAM page `page` for writing, unshared first if a fork holds it.
+        void writable_page(uint8_t page)
+        {
+            int32_t entry = this->f.write_map + page * sizeof(void *);
+            this->e.cmp_null(entry);
+            size_t mapped = this->e.jcc8(CC_NE);
+            this->e.call(reinterpret_cast<const void *>(&unshare_ram), page << 8);
+            this->e.patch(mapped);
+            this->e.load_page(entry);
+        }
+
+        // Register into memory, RAM only.
+        bool store(AddressingMode mode, int32_t reg, uint8_t lo, uint8_t hi)
+        {
+            uint16_t addr = static_cast<uint16_t>(hi) << 8 | lo;
+            switch (mode)
+            {
+            case AddressingMode::ZeroPage:
+                this->writable_page(0);
+                this->e.load8(CL, reg);
+                this->e.store8_page(lo, CL);
+                this->check_code_page(0);
+                return true;
+            case AddressingMode::ZeroPageX:
+            case AddressingMode::ZeroPageY:
+                this->writable_page(0);
+                this->e.load_index(mode == AddressingMode::ZeroPageX ? this->f.x : this->f.y);
+                this->e.add_al_imm(lo);
+                this->e.load8(CL, reg);
+                this->e.store8_page_indexed(CL);
+                this->check_code_page(0);
+                return true;
+            case AddressingMode::Absolute:
+                if (addr > RAM_END)
+                {
+                    return false;
+                }
+                this->writable_page(hi);
+                this->e.load8(CL, reg);
+                this->e.store8_page(lo, CL);
+                this->check_code_page((addr & 0x7FF) >> 8);
+                return true;
+            default:
+                return false;
+            }
+        }
+
+#ifdef NES_LAZY_FLAGS
+        void set_nz(Reg reg)
+        {
+            this->e.store8(this->f.zero, reg);
+            this->e.store8(this->f.negative, reg);
+        }
+#endif
+
+        // Emits code that sets the CPU flags: the returned condition is true
+        // when `flag` is set.
+        Cond test_flag(uint8_t flag)
+        {
+#ifdef NES_LAZY_FLAGS
+            switch (flag)
+            {
+            case cpu_flags::CARRY:
+                this->e.cmp_imm8(this->f.carry, 0);
+                return CC_NE;
+            case cpu_flags::ZERO:
+                this->e.cmp_imm8(this->f.zero, 0);
+                return CC_E;
+            case cpu_flags::NEGATIVE:
+                this->e.test_imm8(this->f.negative, cpu_flags::NEGATIVE);
+                return CC_NE;
+            default:
+                this->e.cmp_imm8(this->f.overflow, 0);
+                return CC_NE;
+            }
+#else
+            this->e.test_imm8(this->f.status, flag);
+            return CC_NE;
+#endif
+        }
+
+        int32_t register_of(char name)
+        {
+            return name == 'A' ? this->f.a : name == 'X' ? this->f.x : this->f.y;
+        }
+
+        // Inline code for one instruction that stays in straight-line flow.
+        // False if it has to go through its handler.
+        bool native(const OpCode &op, uint8_t lo, uint8_t hi)
+        {
+            const char *name = op.code_name;
+            auto is = [name](const char *other)
+            { return std::strcmp(name, other) == 0; };
+
+            // undocumented NOPs only skip their operand, zero page reads
+            // have no side effects.
+            if (op.opcode == 0xEA || (is("*NOP") && !op.page_cross && op.mode != AddressingMode::Absolute))
+            {
+                return true;
+            }
+            if (is("STA") || is("STX") || is("STY"))
+            {
+                return this->store(op.mode, this->register_of(name[2]), lo, hi);
+            }
+            if (is("TXS"))
+            {
+                this->e.load8(AL, this->f.x);
+                this->e.store8(this->f.sp, AL);
+                return true;
+            }
+            if (is("CLI") || is("CLD"))
+            {
+                this->e.and_imm8(this->f.status, static_cast<uint8_t>(~(is("CLI") ? cpu_flags::INTERRUPT : cpu_flags::DECIMAL_UNUSED)));
+                return true;
+            }
+            if (is("SEI") || is("SED"))
+            {
+                this->e.or_imm8(this->f.status, is("SEI") ? cpu_flags::INTERRUPT : cpu_flags::DECIMAL_UNUSED);
+                return true;
+            }
+#ifdef NES_LAZY_FLAGS
+            if (is("CLC") || is("SEC"))
+            {
+                this->e.store_imm8(this->f.carry, is("SEC"));
+                return true;
+            }
+            if (is("CLV"))
+            {
+                this->e.store_imm8(this->f.overflow, 0);
+                return true;
+            }
+            if (is("LDA") || is("LDX") || is("LDY"))
+            {
+                if (!this->load_operand(op.mode, lo, hi))
+                {
+                    return false;
+                }
+                this->e.store8(this->register_of(name[2]), CL);
+                this->set_nz(CL);
+                return true;
+            }
+            if (is("AND") || is("ORA") || is("EOR"))
+            {
+                if (!this->load_operand(op.mode, lo, hi))
+                {
+                    return false;
+                }
+                this->e.load8(AL, this->f.a);
+                this->e.alu_al_cl(is("AND") ? X86_AND : is("ORA") ? X86_OR : X86_XOR);
+                this->e.store8(this->f.a, AL);
+                this->set_nz(AL);
+                return true;
+            }
+            if (is("CMP") || is("CPX") || is("CPY"))
+            {
+                if (!this->load_operand(op.mode, lo, hi))
+                {
+                    return false;
+                }
+                this->e.load8(AL, is("CMP") ? this->f.a : this->register_of(name[2]));
+                this->e.alu_al_cl(X86_SUB);
+                // no borrow: register >= operand.
+                this->e.setcc(CC_AE, this->f.carry);
+                this->set_nz(AL);
+                return true;
+            }
+            if (is("ADC") || is("SBC"))
+            {
+                if (!this->load_operand(op.mode, lo, hi))
+                {
+                    return false;
+                }
+                this->e.load8(DL, this->f.carry);
+                this->e.byte(0x80); // adc: CF = carry (add dl, 0xFF), sbb: CF = !carry (cmp dl, 1)
+                if (is("ADC"))
+                {
+                    this->e.byte(0xC2);
+                    this->e.byte(0xFF);
+                }
+                else
+                {
+                    this->e.byte(0xFA);
+                    this->e.byte(0x01);
+                }
+                this->e.load8(AL, this->f.a);
+                this->e.alu_al_cl(is("ADC") ? X86_ADC : X86_SBB);
+                // x86 carry out is the 6502 carry for ADC and its inverse (borrow) for SBC.
+                this->e.setcc(is("ADC") ? CC_B : CC_AE, this->f.carry);
+                this->e.setcc(CC_O, this->f.overflow);
+                this->e.store8(this->f.a, AL);
+                this->set_nz(AL);
+                return true;
+            }
+            if ((is("INC") || is("DEC")) && (op.mode == AddressingMode::ZeroPage || op.mode == AddressingMode::Absolute))
+            {
+                uint16_t addr = op.mode == AddressingMode::ZeroPage ? lo : static_cast<uint16_t>(hi) << 8 | lo;
+                if (addr > RAM_END)
+                {
+                    return false;
+                }
+                this->writable_page(static_cast<uint8_t>(addr >> 8));
+                is("INC") ? this->e.inc8_page(addr & 0xFF) : this->e.dec8_page(addr & 0xFF);
+                this->e.load8_page(AL, addr & 0xFF);
+                this->set_nz(AL);
+                this->check_code_page((addr & 0x7FF) >> 8);
+                return true;
+            }
+            if (is("INX") || is("INY") || is("DEX") || is("DEY"))
+            {
+                int32_t reg = this->register_of(name[2]);
+                name[0] == 'I' ? this->e.inc8(reg) : this->e.dec8(reg);
+                this->e.load8(AL, reg);
+                this->set_nz(AL);
+                return true;
+            }
+            if (is("TAX") || is("TAY") || is("TXA") || is("TYA") || is("TSX"))
+            {
+                this->e.load8(AL, name[1] == 'S' ? this->f.sp : this->register_of(name[1]));
+                this->e.store8(this->register_of(name[2]), AL);
+                this->set_nz(AL);
+                return true;
+            }
+            if (op.opcode == 0x0A || op.opcode == 0x4A)
+            {
+                // ASL A / LSR A, the bit shifted out is the carry.
+                this->e.load8(AL, this->f.a);
+                this->e.byte(0xD0);
+                this->e.byte(op.opcode == 0x0A ? 0xE0 : 0xE8);
+                this->e.setcc(CC_B, this->f.carry);
+                this->e.store8(this->f.a, AL);
+                this->set_nz(AL);
+                return true;
+            }
+#endif
+            return false;
+        }
+    };
+
+    // Conditional branches: opcode, flag tested, taken when the flag is set.
+    struct Branch
+    {
+        uint8_t opcode;
+        uint8_t flag;
+        bool when_set;
+    };
+    const Branch BRANCHES[] = {
+        {0x10, cpu_flags::NEGATIVE, false}, // BPL
+        {0x30, cpu_flags::NEGATIVE, true},  // BMI
+        {0x50, cpu_flags::OVERFLW, false},  // BVC
+        {0x70, cpu_flags::OVERFLW, true},   // BVS
+        {0x90, cpu_flags::CARRY, false},    // BCC
+        {0xB0, cpu_flags::CARRY, true},     // BCS
+        {0xD0, cpu_flags::ZERO, false},     // BNE
+        {0xF0, cpu_flags::ZERO, true},      // BEQ
+    };
+
+    const Branch *find_branch(uint8_t opcode)
+    {
+        for (const Branch &branch : BRANCHES)
+        {
+            if (branch.opcode == opcode)
+            {
+                return &branch;
+            }
+        }
+        return nullptr;
+    }
+}
+
+NativeBlock jit_compile(CPU &cpu, const BlockCache::Block &block, JitBuffer &buffer)
+{
+    const DecodedOp *ops = &cpu.block_cache.ops[block.first];
+    const OpCode &last = OP_CODES[ops[block.count - 1].opcode];
+    if (buffer.code == nullptr || !last.valid() || last.halts())
+    {
+        return nullptr;
+    }
+
+    Translator t{cpu, fields(cpu), Emitter{}};
+    Emitter &e = t.e;
+    e.prologue();
+
+    // cycles of the inline instructions, handlers count their own.
+    uint32_t cycles = 0;
+    uint16_t pc = block.start;
+    bool pc_set = false; // the last handler was a jump.
+    bool done = false;   // the last instruction emitted the epilogue.
+    for (uint8_t i = 0; i < block.count; ++i)
+    {
+        const DecodedOp &decoded = ops[i];
+        const OpCode &op = OP_CODES[decoded.opcode];
+        uint8_t lo = cpu.bus.peek(pc + 1);
+        uint8_t hi = cpu.bus.peek(pc + 2);
+        uint16_t next = pc + decoded.len;
+        bool is_last = i + 1 == block.count;
+
+        const Branch *branch = is_last ? find_branch(op.opcode) : nullptr;
+        if (branch != nullptr)
+        {
+            // +1 cycle if taken, +1 more if it lands on another page.
+            uint16_t target = next + static_cast<uint16_t>(static_cast<int8_t>(lo));
+            uint32_t taken_cycles = (next & 0xFF00) != (target & 0xFF00) ? 2 : 1;
+            e.add64_imm(t.f.cycles, cycles + op.cycles);
+            Cond set = t.test_flag(branch->flag);
+            size_t taken = e.jcc8(branch->when_set ? set : static_cast<Cond>(set ^ 1));
+            e.store_imm16(t.f.pc, next);
+            e.epilogue();
+            e.patch(taken);
+            e.add64_imm(t.f.cycles, taken_cycles);
+            e.store_imm16(t.f.pc, target);
+            e.epilogue();
+            done = true;
+            break;
+        }
+        if (is_last && op.opcode == 0x4C)
+        {
+            cycles += op.cycles;
+            e.add64_imm(t.f.cycles, cycles);
+            e.store_imm16(t.f.pc, static_cast<uint16_t>(hi) << 8 | lo);
+            e.epilogue();
+            done = true;
+            break;
+        }
+
+        if (t.native(op, lo, hi))
+        {
+            cycles += op.cycles;
+        }
+        else
+        {
+            // the handler expects pc past the opcode byte and advances it.
+            e.store_imm16(t.f.pc, pc + 1);
+            e.call(reinterpret_cast<const void *>(decoded.handler));
+            // jumps set pc themselves.
+            pc_set = is_last && (op.opcode == 0x20 || op.opcode == 0x60 || op.opcode == 0x40 || op.opcode == 0x6C);
+        }
+        pc = next;
+    }
+
+    if (!done)
+    {
+        if (cycles != 0)
+        {
+            e.add64_imm(t.f.cycles, cycles);
+        }
+        if (!pc_set)
+        {
+            e.store_imm16(t.f.pc, pc);
+        }
+        e.epilogue();
+    }
+
+    return reinterpret_cast<NativeBlock>(buffer.append(e.code.data(), e.code.size()));
+}
+
+// Only called from the block loop, never while native code runs.
+void CPU::jit_compile_block(BlockCache::Block &block)
+{
+    auto forget_native = [this]()
+    {
+        for (BlockCache::Block &cached : this->block_cache.blocks)
+        {
+            cached.native = nullptr;
+            cached.hits = 0;
+        }
+    };
+    if (!this->jit_buffer_owner.owned)
+    {
+        // none yet, or shared with a copy of this CPU: start a private
+        // buffer of the same size.
+        forget_native();
+        this->jit_buffer = std::make_shared<JitBuffer>(this->jit_buffer ? this->jit_buffer->size : JIT_BUFFER_SIZE);
+        this->jit_buffer_owner.owned = true;
+    }
+    block.native = jit_compile(*this, block, *this->jit_buffer);
+    if (block.native == nullptr && this->jit_buffer->full)
+    {
+        // start over, blocks that are still hot get translated again.
+        forget_native();
+        this->jit_buffer->clear();
+        this->jit_flushes++;
+        block.native = jit_compile(*this, block, *this->jit_buffer);
+    }
+}
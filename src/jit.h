@@ -0,0 +1,74 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <cstddef>
+#include <cstdint>
+#include "block_cache.h"
+
+// x86-64 translation of hot ROM blocks, only built with NES_JIT.
+
+// entries before a ROM block is translated.
+const uint32_t JIT_THRESHOLD = 16;
+// executable memory per CPU, every translation is dropped once it is full.
+const size_t JIT_BUFFER_SIZE = 4 << 20;
+
+// Executable memory the translated blocks are appended to. No page is
+// writable and executable at once: pages are mapped read/write and turn
+// read/execute once code is copied to them.
+struct JitBuffer
+{
+    explicit JitBuffer(size_t size = JIT_BUFFER_SIZE);
+    ~JitBuffer();
+    JitBuffer(const JitBuffer &) = delete;
+    JitBuffer &operator=(const JitBuffer &) = delete;
+
+    // Copies `count` bytes of code after the last block and returns where
+    // they start, nullptr if they don't fit. The pages written are
+    // read/write only during the copy.
+    uint8_t *append(const uint8_t *bytes, size_t count);
+    // Forgets every block, nothing may still point into the buffer.
+    void clear();
+
+    uint8_t *code;
+    size_t size;
+    size_t used = 0;
+    bool full = false; // an append() did not fit since the last clear().
+};
+
+// Whether a CPU may write the code buffer it holds. Copying a CPU shares
+// the buffer, so it clears the mark on both sides and each starts a
+// private buffer on its next translation; moving hands it over. Tracked
+// here rather than read from use_count(), which copies on other threads
+// change under us (see Bus::owned).
+struct JitBufferOwner
+{
+    mutable bool owned = false;
+
+    JitBufferOwner() = default;
+    JitBufferOwner(const JitBufferOwner &other) { other.owned = false; }
+    JitBufferOwner(JitBufferOwner &&other) noexcept : owned(other.owned) { other.owned = false; }
+    JitBufferOwner &operator=(const JitBufferOwner &other)
+    {
+        this->owned = false;
+        other.owned = false;
+        return *this;
+    }
+    JitBufferOwner &operator=(JitBufferOwner &&other) noexcept
+    {
+        if (this != &other)
+        {
+            this->owned = other.owned;
+            other.owned = false;
+        }
+        return *this;
+    }
+};
+
+// Translates a block decoded from ROM. Register, flag, zero page and RAM
+// accesses are emitted inline; every other instruction (and any access
+// that may reach I/O) calls the interpreter's handler for that opcode.
+// Returns nullptr if the block ends in BRK or an unknown opcode, or if the
+// buffer is full (buffer.full is set).
+NativeBlock jit_compile(CPU &cpu, const BlockCache::Block &block, JitBuffer &buffer);
+
+#endif // !JIT_H
@@ -1,7 +0,0 @@
-#include <iostream>
-#include <cassert>
-#include "cpu.h"
-
-int main() {
-    return 0;
-}
@@ -0,0 +1,257 @@
+#include "rewind.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    const size_t STATE_SIZE = sizeof(SaveState);
+    // zero runs shorter than this stay inside a literal.
+    const size_t MIN_ZERO_RUN = 4;
+    // every (zeros, literal) token costs 4 bytes and skips MIN_ZERO_RUN.
+    const size_t MAX_DELTA = STATE_SIZE + STATE_SIZE / MIN_ZERO_RUN * 4 + 4;
+
+    void put_u16(std::vector<uint8_t> &out, size_t value)
+    {
+        out.push_back(static_cast<uint8_t>(value));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+    }
+
+    size_t get_u16(const uint8_t *in)
+    {
+        return static_cast<size_t>(in[0]) | static_cast<size_t>(in[1]) << 8;
+    }
+
+    // XOR of the two states as (zero run, literal length, literal bytes)
+    // tokens, the last token ends at STATE_SIZE.
+    void encode(const SaveState &state, const SaveState &base, std::vector<uint8_t> &out)
+    {
+        uint8_t delta[STATE_SIZE];
+        const uint8_t *a = reinterpret_cast<const uint8_t *>(&state);
+        const uint8_t *b = reinterpret_cast<const uint8_t *>(&base);
+        for (size_t i = 0; i < STATE_SIZE; ++i)
+        {
+            delta[i] = a[i] ^ b[i];
+        }
+
+        out.clear();
+        size_t pos = 0;
+        while (pos < STATE_SIZE)
+        {
+            size_t zeros = pos;
+            while (zeros < STATE_SIZE && delta[zeros] == 0)
+            {
+                zeros++;
+            }
+            // the literal ends where MIN_ZERO_RUN zeros in a row start.
+            size_t end = zeros;
+            size_t run = 0;
+            while (end < STATE_SIZE)
+            {
+                run = delta[end] == 0 ? run + 1 : 0;
+                end++;
+                if (run == MIN_ZERO_RUN)
+                {
+                    end -= MIN_ZERO_RUN;
+                    break;
+                }
+            }
+            put_u16(out, zeros - pos);
+            put_u16(out, end - zeros);
+            out.insert(out.end(), delta + zeros, delta + end);
+            pos = end;
+        }
+    }
+
+    void apply(SaveState &state, const uint8_t *in)
+    {
+        uint8_t *bytes = reinterpret_cast<uint8_t *>(&state);
+        size_t pos = 0;
+        while (pos < STATE_SIZE)
+        {
+            pos += get_u16(in);
+            size_t literal = get_u16(in + 2);
+            in += 4;
+            for (size_t i = 0; i < literal; ++i)
+            {
+                bytes[pos++] ^= *in++;
+            }
+        }
+    }
+}
+
+Rewind::Rewind(RewindOptions options) : options(options), ring(options.budget), last()
+{
+    // room for a keyframe group to survive while the next one is written.
+    if (options.budget < 2 * MAX_DELTA || options.interval == 0 || options.keyframe_interval == 0)
+    {
+        std::cerr << "Rewind budget must be at least " << 2 * MAX_DELTA << " bytes" << std::endl;
+        exit(1);
+    }
+    this->scratch.reserve(MAX_DELTA);
+}
+
+StopReason Rewind::run(CPU &cpu, uint64_t budget)
+{
+    if (this->captures == 0)
+    {
+        this->capture(cpu);
+        this->next_capture = (this->options.count_cycles ? cpu.cycles : 0) + this->options.interval;
+    }
+
+    if (this->options.count_cycles)
+    {
+        // chunks end on absolute targets, so the run stops where one
+        // run_for_cycles(budget) call would.
+        uint64_t end = cpu.cycles + budget;
+        while (cpu.cycles < end)
+        {
+            uint64_t target = std::min(end, this->next_capture);
+            if (cpu.cycles < target)
+            {
+                StopReason reason = cpu.run_for_cycles(target - cpu.cycles);
+                if (reason != StopReason::Budget)
+                {
+                    return reason;
+                }
+            }
+            if (cpu.cycles >= this->next_capture)
+            {
+                this->capture(cpu);
+                this->next_capture = cpu.cycles + this->options.interval;
+            }
+        }
+        return StopReason::Budget;
+    }
+
+    uint64_t end = this->instructions + budget;
+    while (this->instructions < end)
+    {
+        uint64_t target = std::min(end, this->next_capture);
+        // counts what ran before an early stop too, later captures stay on
+        // their instruction.
+        StopReason reason = cpu.run_for_instructions(target - this->instructions, this->instructions);
+        if (reason != StopReason::Budget)
+        {
+            return reason;
+        }
+        if (this->instructions == this->next_capture)
+        {
+            this->capture(cpu);
+            this->next_capture += this->options.interval;
+        }
+    }
+    return StopReason::Budget;
+}
+
+void Rewind::capture(const CPU &cpu)
+{
+    auto start = std::chrono::steady_clock::now();
+    SaveState state = cpu.save_state();
+    bool keyframe = this->entries.empty() || this->since_keyframe == this->options.keyframe_interval;
+    encode(state, keyframe ? SaveState() : this->last, this->scratch);
+
+    size_t offset = this->allocate(this->scratch.size());
+    if (!keyframe && this->entries.empty())
+    {
+        // making room dropped the delta's base.
+        keyframe = true;
+        encode(state, SaveState(), this->scratch);
+        offset = this->allocate(this->scratch.size());
+    }
+    std::copy(this->scratch.begin(), this->scratch.end(), this->ring.begin() + offset);
+    this->entries.push_back(Entry{offset, static_cast<uint32_t>(this->scratch.size()), keyframe, state.cycles});
+    this->used += this->scratch.size();
+    this->since_keyframe = keyframe ? 1 : this->since_keyframe + 1;
+    this->last = state;
+
+    this->captures++;
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    this->capture_seconds += elapsed.count();
+}
+
+bool Rewind::restore(CPU &cpu, size_t back)
+{
+    if (back >= this->entries.size())
+    {
+        return false;
+    }
+    size_t index = this->entries.size() - 1 - back;
+    size_t first = index;
+    while (!this->entries[first].keyframe)
+    {
+        first--;
+    }
+
+    SaveState state = SaveState();
+    for (size_t i = first; i <= index; ++i)
+    {
+        apply(state, this->ring.data() + this->entries[i].offset);
+    }
+    if (!cpu.load_state(state))
+    {
+        return false;
+    }
+
+    while (this->entries.size() > index + 1)
+    {
+        this->used -= this->entries.back().size;
+        this->entries.pop_back();
+    }
+    this->since_keyframe = static_cast<uint32_t>(index - first + 1);
+    this->last = state;
+    // the next capture comes a full interval after the restored one.
+    this->next_capture = (this->options.count_cycles ? cpu.cycles : this->instructions) + this->options.interval;
+    return true;
+}
+
+double Rewind::seconds() const
+{
+    if (this->entries.empty())
+    {
+        return 0;
+    }
+    return (this->entries.back().cycles - this->entries.front().cycles) / CPU_FREQUENCY;
+}
+
+// Place for `size` bytes after the latest entry, wrapping to the start of
+// the ring. Entries in the way are dropped oldest first, so the ring always
+// holds one unbroken run of captures.
+size_t Rewind::allocate(size_t size)
+{
+    size_t offset = 0;
+    if (!this->entries.empty())
+    {
+        offset = this->entries.back().offset + this->entries.back().size;
+    }
+    if (offset + size > this->ring.size())
+    {
+        // the tail past the latest entry holds the oldest ones.
+        while (!this->entries.empty() && this->entries.front().offset >= offset)
+        {
+            this->drop_oldest();
+        }
+        offset = 0;
+    }
+    while (!this->entries.empty() && this->entries.front().offset < offset + size &&
+           this->entries.front().offset + this->entries.front().size > offset)
+    {
+        this->drop_oldest();
+    }
+    return offset;
+}
+
+// Drops the oldest capture and the deltas that can't be decoded without it.
+void Rewind::drop_oldest()
+{
+    do
+    {
+        this->used -= this->entries.front().size;
+        this->entries.pop_front();
+    } while (!this->entries.empty() && !this->entries.front().keyframe);
+    if (this->entries.empty())
+    {
+        this->since_keyframe = 0;
+    }
+}
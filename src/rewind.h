@@ -0,0 +1,73 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "cpu.h"
+
+// NTSC 2A03 clock, converts cycles to seconds of emulation.
+const double CPU_FREQUENCY = 1789773.0;
+
+struct RewindOptions
+{
+    size_t budget = 1 << 20; // bytes of delta storage.
+    uint64_t interval = 10'000; // instructions (or cycles) between captures.
+    bool count_cycles = false;
+    // every Nth capture is stored against zeros, restore() decodes at most
+    // this many deltas.
+    uint32_t keyframe_interval = 32;
+};
+
+// Recent states of one CPU for stepping back in time. Each capture is a
+// SaveState XORed with the previous one and run-length encoded into a ring
+// of `budget` bytes. The oldest captures are dropped to make room, together
+// with the deltas that depended on them.
+struct Rewind
+{
+    explicit Rewind(RewindOptions options = RewindOptions());
+
+    // Runs the CPU for `budget` instructions or cycles (options.count_cycles)
+    // and captures every options.interval, and once before the first run.
+    // StopReason::Budget unless the program stopped first.
+    StopReason run(CPU &cpu, uint64_t budget);
+    void capture(const CPU &cpu);
+    // Loads the state captured `back` captures before the latest one (0 =
+    // latest) and forgets the captures after it. False if it is no longer
+    // held or is from another cartridge.
+    bool restore(CPU &cpu, size_t back);
+
+    size_t size() const { return this->entries.size(); }
+    size_t bytes() const { return this->used; }
+    size_t budget() const { return this->ring.size(); }
+    // emulated time between the oldest and the latest capture.
+    double seconds() const;
+
+    uint64_t captures = 0;
+    double capture_seconds = 0; // wall time spent in capture().
+
+private:
+    struct Entry
+    {
+        size_t offset; // into ring.
+        uint32_t size;
+        bool keyframe;
+        uint64_t cycles;
+    };
+
+    RewindOptions options;
+    std::vector<uint8_t> ring;
+    std::deque<Entry> entries;
+    size_t used = 0;
+    uint32_t since_keyframe = 0; // captures in the newest keyframe's group.
+    SaveState last;              // latest capture, deltas are against it.
+    std::vector<uint8_t> scratch;
+    uint64_t next_capture = 0;
+    uint64_t instructions = 0;
+
+    size_t allocate(size_t size);
+    void drop_oldest();
+};
+
+#endif // !REWIND_H
@@ -0,0 +1,104 @@
+#include "rom.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+Rom::Rom(std::vector<uint8_t> raw)
+{
+    auto buffer = std::make_shared<const std::vector<uint8_t>>(std::move(raw));
+    this->storage = buffer;
+    this->parse(buffer->data(), buffer->size());
+}
+
+Rom::Rom(const std::string &file)
+{
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Failed to open file: " << file << std::endl;
+        exit(1);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        std::cerr << "Failed to read file: " << file << std::endl;
+        close(fd);
+        exit(1);
+    }
+
+    size_t size = static_cast<size_t>(info.st_size);
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after the descriptor is closed.
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "Failed to map file: " << file << std::endl;
+        exit(1);
+    }
+
+    this->storage = std::shared_ptr<const void>(mapping, [size](const void *addr)
+                                                { munmap(const_cast<void *>(addr), size); });
+    this->parse(static_cast<const uint8_t *>(mapping), size);
+}
+
+void Rom::parse(const uint8_t *raw, size_t size)
+{
+    if (size < NES_HEADER_SIZE)
+    {
+        std::cerr << "Invalid ROM file, not in NES format.\n";
+        exit(1);
+    }
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        if (raw[i] != NES_TAG[i])
+        {
+            std::cerr << "Invalid ROM file, not in NES format.\n";
+            exit(1);
+        }
+    }
+
+    uint8_t mapper = (raw[7] & 0b1111'0000) | (raw[6] >> 4);
+
+    uint8_t ines_version = (raw[7] >> 2) & 0b0000'0011;
+    if (ines_version != 0)
+    {
+        std::cerr << "NES 2.0 format not supported.\n";
+        exit(1);
+    }
+
+    bool four_screen = (raw[6] & 0b1000) != 0;
+    bool vertical_mirrowig = (raw[6] & 0b1) != 0;
+    Mirroring screen_mirroring = four_screen ? Mirroring::FOUR_SCREEN : vertical_mirrowig ? Mirroring::VERTICAL
+                                                                                          : Mirroring::HORIZONTAL;
+    size_t prg_rom_size = static_cast<size_t>(raw[4]) * PRG_ROM_PAGE_SIZE;
+    size_t chr_rom_size = static_cast<size_t>(raw[5]) * CHR_ROM_PAGE_SIZE;
+
+    bool skip_trainer = (raw[6] & 0b100) != 0;
+
+    size_t prg_rom_start = NES_HEADER_SIZE + (skip_trainer ? TRAINER_SIZE : 0);
+    size_t chr_rom_start = prg_rom_start + prg_rom_size;
+
+    if (chr_rom_start + chr_rom_size > size)
+    {
+        std::cerr << "Invalid ROM file, truncated PRG/CHR data.\n";
+        exit(1);
+    }
+
+    this->prg_rom = RomSpan{raw + prg_rom_start, prg_rom_size};
+    this->chr_rom = RomSpan{raw + chr_rom_start, chr_rom_size};
+    this->screen_mirroring = screen_mirroring;
+    this->mapper = mapper;
+
+    this->hash = 0xcbf29ce484222325;
+    for (const RomSpan &span : {this->prg_rom, this->chr_rom})
+    {
+        for (uint8_t byte : span)
+        {
+            this->hash ^= byte;
+            this->hash *= 0x100000001b3;
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef ROM_H
+#define ROM_H
+
+#include <cstdint>
+#include <vector>
+#include <iostream>
+#include <memory>
+#include <string>
+
+const uint8_t NES_TAG[4] = {0x4E, 0x45, 0x53, 0x1A};
+const size_t NES_HEADER_SIZE = 16;
+const size_t TRAINER_SIZE = 512;
+const size_t PRG_ROM_PAGE_SIZE = 16384; // 16KB
+const size_t CHR_ROM_PAGE_SIZE = 8192; // 8KB
+
+enum Mirroring {
+    VERTICAL,
+    HORIZONTAL,
+    FOUR_SCREEN,
+};
+
+// Read-only view into the bytes of a ROM image.
+struct RomSpan {
+    const uint8_t *ptr = nullptr;
+    size_t len = 0;
+
+    const uint8_t *data() const { return ptr; }
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    const uint8_t &operator[](size_t i) const { return ptr[i]; }
+    const uint8_t *begin() const { return ptr; }
+    const uint8_t *end() const { return ptr + len; }
+};
+
+struct Rom {
+    RomSpan prg_rom;
+    RomSpan chr_rom;
+    uint8_t mapper;
+    Mirroring screen_mirroring;
+    // FNV-1a of PRG and CHR, save states name their cartridge by it.
+    uint64_t hash = 0;
+    // owns the image prg_rom/chr_rom point into: a file mapping or a buffer.
+    std::shared_ptr<const void> storage;
+
+    Rom() {};
+    // takes over the buffer, PRG/CHR are not copied out of it.
+    explicit Rom(std::vector<uint8_t> raw);
+    // maps the iNES file read-only.
+    explicit Rom(const std::string &file);
+
+private:
+    void parse(const uint8_t *raw, size_t size);
+};
+
+#endif // !ROM_H
@@ -0,0 +1,79 @@
+#include "save_state.h"
+#include "cpu.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+bool valid_state(const SaveState &state)
+{
+    return std::memcmp(state.magic, SAVE_STATE_MAGIC, sizeof(SAVE_STATE_MAGIC)) == 0 &&
+           state.version == SAVE_STATE_VERSION && state.size == sizeof(SaveState);
+}
+
+void write_state(const std::string &file, const SaveState &state)
+{
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    if (!out.write(reinterpret_cast<const char *>(&state), sizeof(state)))
+    {
+        std::cerr << "Failed to write save state: " << file << std::endl;
+        exit(1);
+    }
+}
+
+SaveState read_state(const std::string &file)
+{
+    SaveState state;
+    std::ifstream in(file, std::ios::binary);
+    if (!in)
+    {
+        std::cerr << "Failed to open file: " << file << std::endl;
+        exit(1);
+    }
+    if (!in.read(reinterpret_cast<char *>(&state), sizeof(state)) || !valid_state(state))
+    {
+        std::cerr << "Invalid save state: " << file << std::endl;
+        exit(1);
+    }
+    return state;
+}
+
+SaveState CPU::save_state() const
+{
+    SaveState state;
+    std::memcpy(state.magic, SAVE_STATE_MAGIC, sizeof(SAVE_STATE_MAGIC));
+    state.version = SAVE_STATE_VERSION;
+    state.size = sizeof(SaveState);
+    state.rom_hash = this->bus.rom ? this->bus.rom->hash : 0;
+    state.cycles = this->cycles;
+    state.pc = this->pc;
+    state.register_a = this->register_a;
+    state.register_x = this->register_x;
+    state.register_y = this->register_y;
+    state.status = this->get_status();
+    state.stack_pointer = this->stack_pointer;
+    state.pending_interrupts = this->pending_interrupts;
+    this->bus.read_ram(state.cpu_vram);
+    return state;
+}
+
+bool CPU::load_state(const SaveState &state)
+{
+    uint64_t rom_hash = this->bus.rom ? this->bus.rom->hash : 0;
+    if (!valid_state(state) || state.rom_hash != rom_hash)
+    {
+        return false;
+    }
+
+    this->cycles = state.cycles;
+    this->pc = state.pc;
+    this->register_a = state.register_a;
+    this->register_x = state.register_x;
+    this->register_y = state.register_y;
+    this->set_status(state.status);
+    this->stack_pointer = state.stack_pointer;
+    this->pending_interrupts = state.pending_interrupts;
+    this->bus.write_ram(state.cpu_vram);
+    // same cartridge, so only blocks decoded from RAM can be stale.
+    this->invalidate_blocks(true);
+    return true;
+}
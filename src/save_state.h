@@ -0,0 +1,39 @@
+#ifndef SAVE_STATE_H
+#define SAVE_STATE_H
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+const char SAVE_STATE_MAGIC[8] = {'N', 'E', 'S', 'S', 'T', 'A', 'T', 'E'};
+const uint32_t SAVE_STATE_VERSION = 1;
+
+// Everything needed to resume a CPU, flat so it is copied and written with
+// memcpy. The cartridge is not stored, only its Rom::hash. Bump the version
+// when fields (e.g. new devices) are added.
+struct SaveState
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t size;     // sizeof(SaveState) of the writer.
+    uint64_t rom_hash; // 0 if no cartridge was loaded.
+    uint64_t cycles;
+    uint16_t pc;
+    uint8_t register_a;
+    uint8_t register_x;
+    uint8_t register_y;
+    uint8_t status; // full byte, N/Z/C/V included.
+    uint8_t stack_pointer;
+    uint8_t pending_interrupts; // was reserved (always 0) before interrupts.
+    uint8_t cpu_vram[2048];
+};
+static_assert(sizeof(SaveState) == 2088, "SaveState layout is part of the save state format");
+static_assert(std::is_trivially_copyable<SaveState>::value, "SaveState must stay memcpy-able");
+
+// true if state has this build's magic, version and size.
+bool valid_state(const SaveState &state);
+// Raw SaveState bytes, exit on I/O errors or a file of another format.
+void write_state(const std::string &file, const SaveState &state);
+SaveState read_state(const std::string &file);
+
+#endif // !SAVE_STATE_H
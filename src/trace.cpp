@@ -0,0 +1,190 @@
+#include "trace.h"
+
+// PPU runs 3 dots per CPU cycle, 341 dots per scanline, 262 scanlines.
+const uint64_t PPU_DOTS_PER_CYCLE = 3;
+const uint64_t PPU_DOTS_PER_SCANLINE = 341;
+const uint64_t PPU_SCANLINES_PER_FRAME = 262;
+// APU and I/O registers, nestest.log shows them as open bus (FF).
+const uint16_t APU_IO_REGISTERS = 0x4000;
+const uint16_t APU_IO_REGISTERS_END = 0x401F;
+
+TraceRecord trace_record(CPU &cpu)
+{
+    Bus &bus = cpu.bus;
+    TraceRecord record{};
+    record.cycles = cpu.cycles;
+    record.pc = cpu.pc;
+    record.register_a = cpu.register_a;
+    record.register_x = cpu.register_x;
+    record.register_y = cpu.register_y;
+    record.status = cpu.get_status();
+    record.stack_pointer = cpu.stack_pointer;
+
+    uint8_t code = bus.peek(cpu.pc);
+    const OpCode &ops = OP_CODES[code];
+    uint8_t len = ops.valid() ? ops.len : 1;
+    for (uint8_t i = 0; i < len; ++i)
+    {
+        record.bytes[i] = bus.peek(cpu.pc + i);
+    }
+
+    uint8_t operand = record.bytes[1];
+    uint16_t operand16 = static_cast<uint16_t>(record.bytes[2]) << 8 | operand;
+    bool has_address = true;
+    switch (ops.mode)
+    {
+    case AddressingMode::ZeroPage:
+        record.addr = operand;
+        break;
+    case AddressingMode::ZeroPageX:
+        record.addr = static_cast<uint8_t>(operand + cpu.register_x);
+        break;
+    case AddressingMode::ZeroPageY:
+        record.addr = static_cast<uint8_t>(operand + cpu.register_y);
+        break;
+    case AddressingMode::Absolute:
+        record.addr = operand16;
+        break;
+    case AddressingMode::AbsoluteX:
+        record.addr = operand16 + cpu.register_x;
+        break;
+    case AddressingMode::AbsoluteY:
+        record.addr = operand16 + cpu.register_y;
+        break;
+    case AddressingMode::IndirectX:
+    {
+        uint8_t ptr = operand + cpu.register_x;
+        record.addr = static_cast<uint16_t>(bus.peek(static_cast<uint8_t>(ptr + 1))) << 8 | bus.peek(ptr);
+        break;
+    }
+    case AddressingMode::IndirectY:
+    {
+        uint16_t base = static_cast<uint16_t>(bus.peek(static_cast<uint8_t>(operand + 1))) << 8 | bus.peek(operand);
+        record.addr = base + cpu.register_y;
+        break;
+    }
+    default:
+        has_address = false;
+        break;
+    }
+
+    if (has_address)
+    {
+        bool apu_io = record.addr >= APU_IO_REGISTERS && record.addr <= APU_IO_REGISTERS_END;
+        record.value = apu_io ? 0xFF : bus.peek(record.addr);
+    }
+    else if (code == 0x6c)
+    {
+        // indirect jmp, the pointer does not cross pages (6502 bug).
+        uint16_t hi_addr = (operand16 & 0xFF00) | static_cast<uint8_t>(operand16 + 1);
+        record.value = static_cast<uint16_t>(bus.peek(hi_addr)) << 8 | bus.peek(operand16);
+    }
+    return record;
+}
+
+std::string format_trace(const TraceRecord &record, bool cycles)
+{
+    const OpCode &ops = OP_CODES[record.bytes[0]];
+    uint8_t len = ops.valid() ? ops.len : 1;
+    uint8_t address = record.bytes[1];
+    uint16_t address16 = static_cast<uint16_t>(record.bytes[2]) << 8 | address;
+    uint8_t stored_value = static_cast<uint8_t>(record.value);
+
+    std::string tmp = "";
+    switch (len)
+    {
+    case 1:
+    {
+        if (ops.mode == AddressingMode::NoneAddressing && ops.valid() &&
+            (record.bytes[0] == 0x0a || record.bytes[0] == 0x4a || record.bytes[0] == 0x2a || record.bytes[0] == 0x6a))
+        {
+            tmp = "A ";
+        }
+        break;
+    }
+    case 2:
+    {
+        switch (ops.mode)
+        {
+        case AddressingMode::Immediate:
+            tmp = fmt::format("#${:02X}", address);
+            break;
+        case AddressingMode::ZeroPage:
+            tmp = fmt::format("${:02X} = {:02X}", record.addr, stored_value);
+            break;
+        case AddressingMode::ZeroPageX:
+            tmp = fmt::format("${:02X},X @ {:02X} = {:02X}", address, record.addr, stored_value);
+            break;
+        case AddressingMode::ZeroPageY:
+            tmp = fmt::format("${:02X},Y @ {:02X} = {:02X}", address, record.addr, stored_value);
+            break;
+        case AddressingMode::IndirectX:
+            tmp = fmt::format("(${:02X},X) @ {:02X} = {:04X} = {:02X}", address, static_cast<uint8_t>(address + record.register_x), record.addr, stored_value);
+            break;
+        case AddressingMode::IndirectY:
+            tmp = fmt::format("(${:02X}),Y = {:04X} @ {:04X} = {:02X}", address, static_cast<uint16_t>(record.addr - record.register_y), record.addr, stored_value);
+            break;
+        default:
+        {
+            // relative branch.
+            uint16_t jmp_addr = record.pc + 2 + static_cast<uint16_t>(static_cast<int8_t>(address));
+            tmp = fmt::format("${:04X}", jmp_addr);
+            break;
+        }
+        }
+        break;
+    }
+    case 3:
+    {
+        switch (ops.mode)
+        {
+        case AddressingMode::Absolute:
+            tmp = fmt::format("${:04X} = {:02X}", address16, stored_value);
+            break;
+        case AddressingMode::AbsoluteX:
+            tmp = fmt::format("${:04X},X @ {:04X} = {:02X}", address16, record.addr, stored_value);
+            break;
+        case AddressingMode::AbsoluteY:
+            tmp = fmt::format("${:04X},Y @ {:04X} = {:02X}", address16, record.addr, stored_value);
+            break;
+        default:
+        {
+            if (record.bytes[0] == 0x6c)
+            {
+                // indirect jmp;
+                tmp = fmt::format("(${:04X}) = {:04X}", address16, record.value);
+            }
+            else
+            {
+                tmp = fmt::format("${:04X}", address16);
+            }
+            break;
+        }
+        }
+        break;
+    }
+    }
+
+    std::string hex_str = "";
+    for (uint8_t i = 0; i < len; ++i)
+    {
+        hex_str += fmt::format("{:02X} ", record.bytes[i]);
+    }
+
+    std::string asm_str = fmt::format("{:04X}  {:9}{:>4} {}", record.pc, hex_str, ops.valid() ? ops.code_name : "???", tmp);
+
+    std::string line = fmt::format("{:47} A:{:02X} X:{:02X} Y:{:02X} P:{:02X} SP:{:02X}",
+                                   asm_str, record.register_a, record.register_x, record.register_y, record.status, record.stack_pointer);
+    if (cycles)
+    {
+        uint64_t dots = record.cycles * PPU_DOTS_PER_CYCLE;
+        line += fmt::format(" PPU:{:3},{:3} CYC:{}",
+                            (dots / PPU_DOTS_PER_SCANLINE) % PPU_SCANLINES_PER_FRAME, dots % PPU_DOTS_PER_SCANLINE, record.cycles);
+    }
+    return line;
+}
+
+std::string trace(CPU &cpu)
+{
+    return format_trace(trace_record(cpu), false);
+}
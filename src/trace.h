@@ -0,0 +1,37 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "cpu.h"
+#include <string>
+#include <type_traits>
+#include <fmt/core.h>
+#include "global.h"
+
+// One instruction as seen right before it executes. Fixed size and
+// trivially copyable so recorders can append it without allocating.
+struct TraceRecord
+{
+    uint64_t cycles;
+    uint16_t pc;
+    uint16_t addr;  // effective address, 0 for implied/immediate operands.
+    uint16_t value; // byte at addr before execution, jump target for JMP ($nnnn).
+    uint8_t bytes[3];
+    uint8_t register_a;
+    uint8_t register_x;
+    uint8_t register_y;
+    uint8_t status;
+    uint8_t stack_pointer;
+};
+static_assert(std::is_trivially_copyable<TraceRecord>::value, "TraceRecord is written raw");
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord layout is part of the trace file format");
+
+// Captures the next instruction without side effects on the bus.
+TraceRecord trace_record(CPU &cpu);
+
+// Renders a record as a nestest.log line. Without cycles the PPU/CYC
+// columns are left out, matching nestest_no_cycle.log.
+std::string format_trace(const TraceRecord &record, bool cycles = true);
+
+std::string trace(CPU &cpu);
+
+#endif // !TRACE_H
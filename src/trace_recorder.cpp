@@ -0,0 +1,118 @@
+#include "trace_recorder.h"
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+TraceRing::TraceRing(size_t capacity) : records(capacity > 0 ? capacity : 1)
+{
+}
+
+size_t TraceRing::size() const
+{
+    return this->total < this->records.size() ? static_cast<size_t>(this->total) : this->records.size();
+}
+
+const TraceRecord &TraceRing::operator[](size_t index) const
+{
+    uint64_t first = this->total - this->size();
+    return this->records[(first + index) % this->records.size()];
+}
+
+TraceFile::TraceFile(const std::string &file, size_t initial_records)
+    : capacity(0), header(nullptr), records(nullptr)
+{
+    this->fd = open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (this->fd < 0)
+    {
+        std::cerr << "Failed to open file: " << file << std::endl;
+        exit(1);
+    }
+    this->map(initial_records > 0 ? initial_records : 1);
+    std::memcpy(this->header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    this->header->version = TRACE_VERSION;
+    this->header->record_size = sizeof(TraceRecord);
+    this->header->count = 0;
+}
+
+TraceFile::~TraceFile()
+{
+    uint64_t count = this->header->count;
+    munmap(this->header, sizeof(TraceHeader) + this->capacity * sizeof(TraceRecord));
+    // drop the unused tail of the last growth step.
+    if (ftruncate(this->fd, sizeof(TraceHeader) + count * sizeof(TraceRecord)) != 0)
+    {
+        std::cerr << "Failed to truncate trace file" << std::endl;
+    }
+    close(this->fd);
+}
+
+void TraceFile::map(size_t records)
+{
+    size_t size = sizeof(TraceHeader) + records * sizeof(TraceRecord);
+    if (ftruncate(this->fd, size) != 0)
+    {
+        std::cerr << "Failed to resize trace file" << std::endl;
+        exit(1);
+    }
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "Failed to map trace file" << std::endl;
+        exit(1);
+    }
+    this->capacity = records;
+    this->header = static_cast<TraceHeader *>(mapping);
+    this->records = reinterpret_cast<TraceRecord *>(static_cast<uint8_t *>(mapping) + sizeof(TraceHeader));
+}
+
+void TraceFile::grow()
+{
+    munmap(this->header, sizeof(TraceHeader) + this->capacity * sizeof(TraceRecord));
+    this->map(this->capacity * 2);
+}
+
+TraceReader::TraceReader(const std::string &file)
+{
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Failed to open file: " << file << std::endl;
+        exit(1);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(TraceHeader))
+    {
+        std::cerr << "Invalid trace file: " << file << std::endl;
+        close(fd);
+        exit(1);
+    }
+
+    this->mapping_size = static_cast<size_t>(info.st_size);
+    this->mapping = mmap(nullptr, this->mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (this->mapping == MAP_FAILED)
+    {
+        std::cerr << "Failed to map file: " << file << std::endl;
+        exit(1);
+    }
+
+    const TraceHeader *header = static_cast<const TraceHeader *>(this->mapping);
+    if (std::memcmp(header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+        header->version != TRACE_VERSION || header->record_size != sizeof(TraceRecord) ||
+        sizeof(TraceHeader) + header->count * sizeof(TraceRecord) > this->mapping_size)
+    {
+        std::cerr << "Invalid trace file: " << file << std::endl;
+        exit(1);
+    }
+    this->count = header->count;
+    this->records = reinterpret_cast<const TraceRecord *>(static_cast<const uint8_t *>(this->mapping) + sizeof(TraceHeader));
+}
+
+TraceReader::~TraceReader()
+{
+    munmap(this->mapping, this->mapping_size);
+}
@@ -0,0 +1,89 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include "trace.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+const char TRACE_MAGIC[8] = {'N', 'E', 'S', 'T', 'R', 'A', 'C', 'E'};
+const uint32_t TRACE_VERSION = 1;
+
+// Header of a binary trace file, records follow it back to back.
+struct TraceHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t count;
+};
+static_assert(sizeof(TraceHeader) == 24, "TraceHeader layout is part of the trace file format");
+
+// Keeps the last `capacity` records in memory, oldest are overwritten.
+struct TraceRing
+{
+    std::vector<TraceRecord> records;
+    uint64_t total = 0; // records ever pushed.
+
+    explicit TraceRing(size_t capacity);
+    void push(CPU &cpu)
+    {
+        this->records[this->total % this->records.size()] = trace_record(cpu);
+        this->total++;
+    }
+    size_t size() const;
+    // 0 is the oldest record still held.
+    const TraceRecord &operator[](size_t index) const;
+};
+
+// Appends records to an mmapped file. The header count is kept current so
+// the file is readable even if the process exits without the destructor.
+struct TraceFile
+{
+    explicit TraceFile(const std::string &file, size_t initial_records = 1 << 16);
+    ~TraceFile();
+    TraceFile(const TraceFile &) = delete;
+    TraceFile &operator=(const TraceFile &) = delete;
+
+    void push(CPU &cpu)
+    {
+        if (this->header->count == this->capacity)
+        {
+            this->grow();
+        }
+        this->records[this->header->count] = trace_record(cpu);
+        this->header->count++;
+    }
+    uint64_t size() const { return this->header->count; }
+
+private:
+    int fd;
+    size_t capacity;
+    TraceHeader *header;
+    TraceRecord *records;
+    void map(size_t records);
+    void grow();
+};
+
+// Read-only view over a trace file written by TraceFile.
+struct TraceReader
+{
+    explicit TraceReader(const std::string &file);
+    ~TraceReader();
+    TraceReader(const TraceReader &) = delete;
+    TraceReader &operator=(const TraceReader &) = delete;
+
+    uint64_t size() const { return this->count; }
+    const TraceRecord &operator[](size_t index) const { return this->records[index]; }
+    const TraceRecord *begin() const { return this->records; }
+    const TraceRecord *end() const { return this->records + this->count; }
+
+private:
+    void *mapping;
+    size_t mapping_size;
+    uint64_t count;
+    const TraceRecord *records;
+};
+
+#endif // !TRACE_RECORDER_H
@@ -0,0 +1,43 @@
+#include "test.h"
+
+// Code in RAM that rewrites an instruction later in its own block, run
+// through both block cache paths.
+const std::vector<uint8_t> PROGRAM = {
+    0xA9, 0xEA,       // LDA #$EA
+    0x8D, 0x07, 0x02, // STA $0207, INX below becomes NOP
+    0xA2, 0x01,       // LDX #$01
+    0xE8,             // INX
+    0x00,             // BRK
+};
+
+void load_program(CPU &cpu)
+{
+    for (size_t i = 0; i < PROGRAM.size(); ++i)
+    {
+        cpu.mem_write(0x0200 + i, PROGRAM[i]);
+    }
+    cpu.pc = 0x0200;
+}
+
+int main() {
+    CPU cpu;
+    load_program(cpu);
+    while (cpu.step_cached())
+    {
+    }
+    assert(cpu.register_x == 0x01 && "Stale INX ran after the write");
+
+    // decode the original program again, then run it through the block loop.
+    load_program(cpu);
+    cpu.run_blocks_until([](CPU &)
+                         { return false; });
+    assert(cpu.register_x == 0x01 && "Stale INX ran after the write");
+
+    // replacing code from outside through mem_write drops the block too.
+    cpu.mem_write(0x0206, 0x41);
+    cpu.pc = 0x0205;
+    cpu.run_blocks_until([](CPU &)
+                         { return false; });
+    assert(cpu.register_x == 0x41 && "Register X should be 0x41");
+    return 0;
+}
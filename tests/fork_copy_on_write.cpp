@@ -0,0 +1,41 @@
+#include "test.h"
+
+// Forks share RAM pages until one side writes them, and every side runs on
+// exactly as a full copy would.
+int main() {
+    CPU parent;
+    parent.load(store_loop());
+    parent.reset();
+#ifdef NES_JIT
+    // the stores then also run as native code.
+    parent.jit_enabled = true;
+    parent.jit_threshold = 1;
+#endif
+    parent.run_for_instructions(500);
+
+    CPU copy = parent;
+    CPU child = parent.fork();
+    assert(same_state(child, parent) && "Fork should start in the parent's state");
+    assert(child.bus.cpu_vram[0] == parent.bus.cpu_vram[0] && "Fork should share RAM pages");
+
+    child.run_for_instructions(500);
+    assert(child.bus.cpu_vram[0] != parent.bus.cpu_vram[0] && "Written page should be copied");
+    assert(child.bus.cpu_vram[3] != parent.bus.cpu_vram[3] && "Written page should be copied");
+    assert(child.bus.cpu_vram[5] == parent.bus.cpu_vram[5] && "Untouched page should stay shared");
+    assert(same_state(parent, copy) && "Child writes should not reach the parent");
+
+    parent.run_for_instructions(500);
+    copy.run_for_instructions(500);
+    assert(same_state(parent, copy) && "Parent should run as if never forked");
+    assert(same_state(child, copy) && "Child should run as the parent does");
+
+    // a page once shared is copied on write, even after the fork is gone.
+    CPU shared;
+    {
+        CPU gone = shared.fork();
+    }
+    [[maybe_unused]] RamPage *before = shared.bus.cpu_vram[0].get();
+    shared.mem_write(0x0010, 0x42);
+    assert(shared.bus.cpu_vram[0].get() != before && shared.mem_read(0x0010) == 0x42);
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "test.h"
+
+// Waits for $20 to become non-zero, the NMI handler at 0x0000 sets it.
+const std::vector<uint8_t> PROGRAM = {
+    0xA5, 0x20, // 8600: LDA $20
+    0xF0, 0xFC, // 8602: BEQ $8600
+    0xA2, 0x01, // 8604: LDX #$01
+    0x00,       // 8606: BRK
+};
+
+const std::vector<uint8_t> HANDLER = {0xA9, 0x01, 0x85, 0x20, 0x40}; // LDA #$01, STA $20, RTI
+
+void start(CPU &cpu, bool skip_idle)
+{
+    cpu.load(PROGRAM);
+    cpu.reset();
+    for (size_t i = 0; i < HANDLER.size(); ++i)
+    {
+        cpu.mem_write(i, HANDLER[i]);
+    }
+    cpu.skip_idle = skip_idle;
+}
+
+int main() {
+    // budgets end on the same instruction as when every iteration runs.
+    CPU interpreted;
+    CPU skipped;
+    start(interpreted, false);
+    start(skipped, true);
+    for (uint64_t budget : {1u, 5u, 1000u, 12345u})
+    {
+        [[maybe_unused]] StopReason expected = interpreted.run_for_cycles(budget);
+        [[maybe_unused]] StopReason reason = skipped.run_for_cycles(budget);
+        assert(reason == expected);
+        assert(same_state(interpreted, skipped) && "Idle skip diverged on a cycle budget");
+        expected = interpreted.run_for_instructions(budget);
+        reason = skipped.run_for_instructions(budget);
+        assert(reason == expected);
+        assert(same_state(interpreted, skipped) && "Idle skip diverged on an instruction budget");
+    }
+    assert(skipped.idle_instructions > 10000 && "The wait loop should be skipped");
+
+    // a write between runs ends the loop.
+    interpreted.mem_write(0x20, 0x01);
+    skipped.mem_write(0x20, 0x01);
+    [[maybe_unused]] StopReason expected = interpreted.run();
+    [[maybe_unused]] StopReason reason = skipped.run();
+    assert(expected == StopReason::Break && reason == StopReason::Break);
+    assert(same_state(interpreted, skipped) && skipped.register_x == 0x01);
+
+    // a pending interrupt ends the skipping, the handler ends the loop.
+    CPU nmi;
+    start(nmi, true);
+    uint64_t claims = 0;
+    reason = nmi.run_until([](CPU &)
+                           { return false; },
+                           [&](CPU &cpu, uint64_t, uint64_t)
+                           {
+                               if (++claims == 100)
+                               {
+                                   cpu.request_nmi();
+                               }
+                               return true; });
+    assert(reason == StopReason::Break && nmi.register_x == 0x01 && "NMI should end the idle loop");
+    assert(nmi.idle_instructions >= 2 * 98 && "The wait loop should be skipped until the NMI");
+
+    // a long wait is claimed in a few large runs, not one claim per iteration.
+    CPU waiting;
+    CPU counted;
+    start(waiting, false);
+    start(counted, true);
+    uint64_t target = counted.cycles + 10000000;
+    claims = 0;
+    expected = waiting.run_for_cycles(10000000);
+    reason = counted.run_until([&](CPU &cpu)
+                               { return cpu.cycles >= target; },
+                               [&](CPU &cpu, uint64_t, uint64_t prefix_cycles)
+                               {
+                                   claims++;
+                                   return cpu.cycles + prefix_cycles < target; });
+    assert(reason == expected && same_state(waiting, counted));
+    assert(claims < 200 && "Idle skip should claim in runs, not per iteration");
+
+    // long budgets through the plain overload end on the same instruction.
+    for (uint64_t budget : {100000u, 1000000u})
+    {
+        CPU full;
+        CPU fast;
+        start(full, false);
+        start(fast, true);
+        [[maybe_unused]] uint64_t begin = fast.cycles;
+        expected = full.run_for_cycles(budget);
+        reason = fast.run_for_cycles(budget);
+        assert(reason == expected && same_state(full, fast) && "Idle skip diverged on a long budget");
+        // the last instruction starts before the budget runs out.
+        assert(fast.cycles - begin >= budget && fast.cycles - begin < budget + 8 && "Idle skip overran the budget");
+    }
+
+    // with run()'s always-true claim, skipping still returns to stop(), so
+    // an interrupt raised there ends the loop, and never wraps cycles.
+    CPU unbounded;
+    start(unbounded, true);
+    const uint64_t begin = UINT64_MAX - 10000000000;
+    unbounded.cycles = begin;
+    bool raised = false;
+    bool wrapped = false;
+    reason = unbounded.run_until([&](CPU &cpu)
+                                 {
+                                     if (!raised && cpu.idle_instructions > 0)
+                                     {
+                                         raised = true;
+                                         wrapped = cpu.cycles < begin;
+                                         cpu.request_nmi();
+                                     }
+                                     return false; },
+                                 [](CPU &, uint64_t, uint64_t)
+                                 { return true; });
+    assert(reason == StopReason::Break && unbounded.register_x == 0x01 && "NMI should end an unbounded skip");
+    assert(raised && !wrapped && "Idle skip should not wrap cycles");
+
+    // forks keep skipping.
+    [[maybe_unused]] CPU forked = unbounded.fork();
+    assert(forked.skip_idle && "Fork should keep skip_idle");
+
+    // loops reading I/O are left alone, the reads have side effects.
+    CPU io;
+    io.load({0xAD, 0x02, 0x20, 0x10, 0xFB}); // LDA $2002, BPL $8600
+    [[maybe_unused]] BlockCache::Block *block = io.decode_block(PROGRAM_START);
+    assert(block != nullptr && !block->idle);
+    return 0;
+}
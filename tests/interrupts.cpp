@@ -0,0 +1,46 @@
+#include "test.h"
+
+// load() leaves the NMI and IRQ/BRK vectors at 0x0000, the handlers below
+// are written to RAM there.
+void start(CPU &cpu, std::vector<uint8_t> program, std::vector<uint8_t> handler)
+{
+    cpu.load(program);
+    cpu.reset();
+    for (size_t i = 0; i < handler.size(); ++i)
+    {
+        cpu.mem_write(i, handler[i]);
+    }
+}
+
+int main() {
+    // NMI before the first instruction, the handler returns with RTI.
+    CPU nmi;
+    start(nmi, {0xA9, 0x01, 0xA0, 0x02, 0x00}, {0xE8, 0x40}); // LDA, LDY, BRK / INX, RTI
+    nmi.request_nmi();
+    nmi.run();
+    assert(nmi.register_x == 0x01 && "NMI handler should run once");
+    assert(nmi.register_a == 0x01 && nmi.register_y == 0x02 && "RTI should resume the program");
+    assert(nmi.stack_pointer == STACK_RESET && "RTI should pop what the NMI pushed");
+    assert(nmi.cycles == 7 + INTERRUPT_CYCLES + 2 + 6 + 2 + 2 + 7 && "NMI entry should take 7 cycles");
+
+    // IRQ waits for CLI, the handler jams so the line can stay asserted.
+    CPU irq;
+    start(irq, {0xEA, 0x58, 0xEA, 0x00}, {0xE8, 0x02}); // NOP, CLI, NOP, BRK / INX, *JAM
+    irq.set_irq(true);
+    irq.run();
+    assert(irq.register_x == 0x01 && "IRQ should be taken after CLI");
+    assert(irq.pc == 0x0001 && "IRQ should jump through 0xFFFE");
+    assert((irq.get_status() & cpu_flags::INTERRUPT) && "IRQ should set I");
+    assert(irq.mem_read_u16(0x01FC) == PROGRAM_START + 2 && "IRQ should push the next instruction");
+    assert(!(irq.mem_read(0x01FB) & cpu_flags::BREAK) && "IRQ should push B clear");
+
+    // BRK as a software interrupt skips its padding byte.
+    CPU brk;
+    brk.halt_on_brk = false;
+    start(brk, {0xA9, 0x05, 0x00, 0xFF}, {0xE8, 0x02}); // LDA, BRK / INX, *JAM
+    brk.run();
+    assert(brk.register_x == 0x01 && "BRK should enter the IRQ handler");
+    assert(brk.mem_read_u16(0x01FC) == PROGRAM_START + 4 && "BRK should push pc + 2");
+    assert((brk.mem_read(0x01FB) & cpu_flags::BREAK) && "BRK should push B set");
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include "test.h"
+
+// 64 blocks of ADC/STA chained by JMPs, the last jumps back to the first.
+// Their native code does not fit a one-page buffer, which is flushed and
+// refilled while the loop runs.
+std::vector<uint8_t> chain()
+{
+    std::vector<uint8_t> program;
+    const size_t blocks = 64;
+    const size_t block_size = 10 * 6 + 3;
+    for (size_t block = 0; block < blocks; ++block)
+    {
+        for (uint8_t i = 0; i < 10; ++i)
+        {
+            program.insert(program.end(), {0xA9, static_cast<uint8_t>(block + i), 0x65, 0x10, 0x85, 0x10}); // LDA #, ADC $10, STA $10
+        }
+        uint16_t next = PROGRAM_START + (block + 1 == blocks ? 0 : (block + 1) * block_size);
+        program.insert(program.end(), {0x4C, static_cast<uint8_t>(next), static_cast<uint8_t>(next >> 8)}); // JMP next
+    }
+    return program;
+}
+
+int main() {
+    CPU interpreted;
+    CPU jit;
+    interpreted.load(chain());
+    jit.load(chain());
+    interpreted.reset();
+    jit.reset();
+    jit.jit_enabled = true;
+    jit.jit_threshold = 1;
+    jit.jit_buffer = std::make_shared<JitBuffer>(4096);
+
+    interpreted.run_for_cycles(200'000);
+    jit.run_for_cycles(200'000);
+    assert(jit.jit_flushes > 0 && "A full buffer should be flushed");
+    assert(jit.jit_instructions > 0 && "Blocks should be translated again after a flush");
+    assert(same_state(jit, interpreted) && "Native code should match the interpreter");
+
+    // a copy shares the buffer, then each side translates into its own.
+    CPU copy = jit;
+    assert(!jit.jit_buffer_owner.owned && !copy.jit_buffer_owner.owned && "A copied buffer should be owned by neither");
+    interpreted.run_for_cycles(200'000);
+    jit.run_for_cycles(200'000);
+    copy.run_for_cycles(200'000);
+    assert(jit.jit_buffer != copy.jit_buffer && "Both sides should translate into private buffers");
+    assert(same_state(jit, interpreted) && same_state(copy, interpreted));
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include "test.h"
+#include "../src/rewind.h"
+
+// Every retained capture restores exactly, runs go on from a restored point,
+// and a small budget keeps only the newest captures.
+int main() {
+    RewindOptions options;
+    options.interval = 100;
+    options.keyframe_interval = 8;
+    Rewind rewind(options);
+
+    CPU cpu;
+    cpu.load(store_loop());
+    cpu.reset();
+    // the run's state at each capture, captured once before it starts.
+    std::vector<SaveState> expected = {cpu.save_state()};
+    for (int i = 0; i < 40; ++i)
+    {
+        rewind.run(cpu, options.interval);
+        expected.push_back(cpu.save_state());
+    }
+    assert(rewind.size() == expected.size() && "Every capture should be held");
+
+    [[maybe_unused]] SaveState latest = cpu.save_state();
+    for (size_t back = 0; back < expected.size(); back += 7)
+    {
+        CPU other;
+        other.load(store_loop());
+        Rewind copy = rewind;
+        [[maybe_unused]] bool restored = copy.restore(other, back);
+        assert(restored && "Capture should be held");
+        assert(same_state(other.save_state(), expected[expected.size() - 1 - back]) && "Restored state should match");
+    }
+
+    // go back 10 captures and run the same 1000 instructions again.
+    [[maybe_unused]] bool restored = rewind.restore(cpu, 10);
+    assert(restored && "Capture should be held");
+    assert(rewind.size() == expected.size() - 10 && "Newer captures should be dropped");
+    rewind.run(cpu, 10 * options.interval);
+    assert(same_state(cpu.save_state(), latest) && "Run from the restored state should match");
+    restored = rewind.restore(cpu, rewind.size());
+    assert(!restored && "Older than the oldest capture");
+
+    // a small ring only keeps the newest whole keyframe groups.
+    RewindOptions small = options;
+    small.budget = 16 * 1024;
+    Rewind ring(small);
+    CPU looped;
+    looped.load(store_loop());
+    looped.reset();
+    for (int i = 0; i < 1000; ++i)
+    {
+        ring.run(looped, small.interval);
+    }
+    assert(ring.bytes() <= ring.budget() && "Ring should stay inside its budget");
+    assert(ring.size() > 0 && ring.size() < 1000 && "Old captures should be dropped");
+    [[maybe_unused]] SaveState now = looped.save_state();
+    restored = ring.restore(looped, 0);
+    assert(restored && same_state(looped.save_state(), now) && "Latest capture should restore");
+    restored = ring.restore(looped, ring.size() - 1);
+    assert(restored && "Oldest held capture should restore");
+
+    // a stop inside a run still counts the instructions before it: after
+    // 4 + 96 instructions the latest capture is the current state.
+    const uint16_t loop = PROGRAM_START + 6;
+    CPU faulting;
+    faulting.load({
+        0xE8, 0xE8,       // INX, INX
+        0xE8,             // INX
+        0x8D, 0x00, 0x90, // STA $9000, a bus fault
+        0xE8,             // loop: INX
+        0x4C, static_cast<uint8_t>(loop), static_cast<uint8_t>(loop >> 8), // JMP loop
+    });
+    faulting.reset();
+    Rewind stopped(options);
+    [[maybe_unused]] StopReason reason = stopped.run(faulting, 100);
+    assert(reason == StopReason::BusFault && "ROM write should stop the run");
+    reason = stopped.run(faulting, 96);
+    assert(reason == StopReason::Budget);
+    [[maybe_unused]] SaveState end = faulting.save_state();
+    restored = stopped.restore(faulting, 0);
+    assert(restored && same_state(faulting.save_state(), end) && "Captures should stay on their instruction");
+    return 0;
+}
@@ -0,0 +1,42 @@
+#include "test.h"
+#include <cstdio>
+
+// Resuming from a save state replays the same instructions to the same
+// registers, flags, cycles and RAM, and a state only loads into its cartridge.
+int main() {
+    CPU cpu;
+    cpu.load(store_loop());
+    cpu.reset();
+    cpu.run_for_instructions(1000);
+    SaveState warm = cpu.save_state();
+
+    cpu.run_for_instructions(1000);
+    [[maybe_unused]] SaveState expected = cpu.save_state();
+    assert(!same_state(warm, expected) && "Program should have changed the state");
+
+    [[maybe_unused]] bool loaded = cpu.load_state(warm);
+    assert(loaded && "State should load into the same CPU");
+    cpu.run_for_instructions(1000);
+    assert(same_state(cpu.save_state(), expected) && "Resumed run should match");
+
+    // a fresh CPU on the same cartridge, through a file.
+    const char *file = "save_state_round_trip.state";
+    write_state(file, warm);
+    CPU other;
+    other.load(store_loop());
+    loaded = other.load_state(read_state(file));
+    assert(loaded && "State should load into the same cartridge");
+    std::remove(file);
+    other.run_for_instructions(1000);
+    assert(same_state(other.save_state(), expected) && "Run from the file should match");
+
+    std::vector<uint8_t> changed = store_loop();
+    changed[4] = 0x05;
+    CPU wrong;
+    wrong.load(changed);
+    wrong.reset();
+    loaded = wrong.load_state(warm);
+    assert(!loaded && "State from another cartridge should be rejected");
+    assert(wrong.pc == 0x8600 && "Rejected state should leave the CPU as is");
+    return 0;
+}
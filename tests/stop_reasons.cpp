@@ -0,0 +1,38 @@
+#include "test.h"
+
+int main() {
+    // a ROM write stops after the instruction, the run resumes from there.
+    CPU cpu;
+    cpu.load({
+        0xA9, 0x01,       // LDA #$01
+        0x8D, 0x00, 0x90, // STA $9000
+        0xE8,             // INX
+        0x00,             // BRK
+    });
+    cpu.reset();
+    [[maybe_unused]] StopReason reason = cpu.run();
+    assert(reason == StopReason::BusFault && "ROM write should be a bus fault");
+    assert(cpu.fault_address == 0x9000 && "fault should record the address");
+    assert(cpu.pc == PROGRAM_START + 5 && cpu.register_x == 0 && "fault should stop after the write");
+    reason = cpu.run();
+    assert(reason == StopReason::Break && cpu.register_x == 1 && "CPU should resume after a fault");
+
+    // budget, host request from a callback, then JAM.
+    CPU host;
+    host.load({0xE8, 0xE8, 0xE8, 0xE8, 0x02}); // INX x4, *JAM
+    host.reset();
+    reason = host.run_for_instructions(1);
+    assert(reason == StopReason::Budget && host.register_x == 1 && "budget should stop");
+    reason = host.run_with([](CPU &cpu)
+                           {
+                               if (cpu.register_x == 2)
+                               {
+                                   cpu.request_stop();
+                               } });
+    assert(reason == StopReason::HostRequest && host.register_x == 2 && "request should stop at the next boundary");
+    reason = host.run();
+    assert(reason == StopReason::Halt && host.pc == PROGRAM_START + 4 && "JAM should halt on the opcode");
+    reason = host.run();
+    assert(reason == StopReason::Halt && host.register_x == 4 && "JAM should stay halted");
+    return 0;
+}
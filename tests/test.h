@@ -3,9 +3,36 @@
 
 #include <cstdint>
 #include <cassert>
+#include <cstring>
 #include <iostream>
+#include <vector>
 #include "../src/cpu.h"
 
-#endif // !TEST_H
+// LDX #$00, then TXA / ADC #$03 / STA $00,X / STA $0300,X / INX forever:
+// registers, flags, cycles and two RAM pages change on every iteration.
+inline std::vector<uint8_t> store_loop()
+{
+    const uint16_t loop = PROGRAM_START + 2;
+    return {
+        0xA2, 0x00,       // LDX #$00
+        0x8A,             // loop: TXA
+        0x69, 0x03,       // ADC #$03
+        0x95, 0x00,       // STA $00,X
+        0x9D, 0x00, 0x03, // STA $0300,X
+        0xE8,             // INX
+        0x4C, static_cast<uint8_t>(loop), static_cast<uint8_t>(loop >> 8), // JMP loop
+    };
+}
+
+// Registers, flags, cycles, pending interrupts, RAM and cartridge.
+inline bool same_state(const SaveState &a, const SaveState &b)
+{
+    return std::memcmp(&a, &b, sizeof(SaveState)) == 0;
+}
 
+inline bool same_state(const CPU &a, const CPU &b)
+{
+    return same_state(a.save_state(), b.save_state());
+}
 
+#endif // !TEST_H
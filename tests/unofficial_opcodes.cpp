@@ -0,0 +1,117 @@
+#include "test.h"
+
+int main() {
+    CPU cpu;
+    cpu.load_and_run({
+        0xA9, 0xF0,       // LDA #$F0
+        0xA2, 0x3C,       // LDX #$3C
+        0xCB, 0x10,       // *AXS #$10, X = (A & X) - $10
+        0x86, 0x10,       // STX $10
+        0xA2, 0x03,       // LDX #$03
+        0xA0, 0x20,       // LDY #$20
+        0x9E, 0xF0, 0x05, // *SHX $05F0,Y, crosses into page $06
+        0x02,             // *JAM
+        0xE8,             // INX, never runs
+    });
+
+    assert(cpu.bus.peek(0x10) == 0x20 && "AXS should leave (A & X) - M in X");
+    assert(cpu.carry_flag() && "AXS should set carry like CMP");
+    // X & ($05 + 1) = $02 is stored, and also becomes the high byte.
+    assert(cpu.bus.peek(0x0210) == 0x02 && "SHX should store to the corrupted address");
+    assert(cpu.register_x == 0x03 && "JAM should stop the CPU");
+    assert(cpu.pc == PROGRAM_START + 15 && "JAM should leave pc on the opcode");
+
+    // read-modify-write combos: the shift or step lands in memory, then
+    // feeds the ALU op.
+    CPU slo;
+    slo.load_and_run({0xA9, 0x81, 0x85, 0x10, 0xA9, 0x01, // LDA #$81, STA $10, LDA #$01
+                      0x07, 0x10});                     // *SLO $10
+    assert(slo.bus.peek(0x10) == 0x02 && slo.register_a == 0x03 && "SLO should ASL M, then ORA");
+    assert(slo.carry_flag() && !slo.negative_flag() && "SLO should carry out bit 7 of M");
+
+    CPU rla;
+    rla.load_and_run({0xA9, 0x80, 0x85, 0x10, 0x38, 0xA9, 0x03, // LDA #$80, STA $10, SEC, LDA #$03
+                      0x27, 0x10});                           // *RLA $10
+    assert(rla.bus.peek(0x10) == 0x01 && rla.register_a == 0x01 && "RLA should ROL M, then AND");
+    assert(rla.carry_flag() && "RLA should carry out bit 7 of M");
+
+    CPU sre;
+    sre.load_and_run({0xA9, 0x03, 0x85, 0x10, 0xA9, 0xFF, // LDA #$03, STA $10, LDA #$FF
+                      0x47, 0x10});                     // *SRE $10
+    assert(sre.bus.peek(0x10) == 0x01 && sre.register_a == 0xFE && "SRE should LSR M, then EOR");
+    assert(sre.carry_flag() && sre.negative_flag() && "SRE should carry out bit 0 of M");
+
+    CPU rra;
+    rra.load_and_run({0xA9, 0x03, 0x85, 0x10, 0x18, 0xA9, 0x10, // LDA #$03, STA $10, CLC, LDA #$10
+                      0x67, 0x10});                           // *RRA $10
+    // ROR gives $01 and carries 1 out, which the ADC adds in.
+    assert(rra.bus.peek(0x10) == 0x01 && rra.register_a == 0x12 && "RRA should ROR M, then ADC with its carry");
+    assert(!rra.carry_flag() && !rra.overflow_flag());
+
+    CPU dcp;
+    dcp.load_and_run({0xA9, 0x10, 0x85, 0x10, 0xA9, 0x0F, // LDA #$10, STA $10, LDA #$0F
+                      0xC7, 0x10});                     // *DCP $10
+    assert(dcp.bus.peek(0x10) == 0x0F && dcp.register_a == 0x0F && "DCP should DEC M, then CMP");
+    assert(dcp.zero_flag() && dcp.carry_flag() && "DCP should compare A with the new M");
+
+    CPU isc;
+    isc.load_and_run({0xA9, 0x0F, 0x85, 0x10, 0x38, 0xA9, 0x80, // LDA #$0F, STA $10, SEC, LDA #$80
+                      0xE7, 0x10});                           // *ISC $10
+    assert(isc.bus.peek(0x10) == 0x10 && isc.register_a == 0x70 && "ISC should INC M, then SBC");
+    assert(isc.carry_flag() && isc.overflow_flag() && !isc.negative_flag() && "ISC should set flags like SBC");
+
+    // LAX loads A and X, SAX stores A & X without setting flags.
+    CPU lax;
+    lax.load_and_run({0xA9, 0x8F, 0x85, 0x10, 0xA9, 0x00, // LDA #$8F, STA $10, LDA #$00
+                      0xA7, 0x10});                     // *LAX $10
+    assert(lax.register_a == 0x8F && lax.register_x == 0x8F && "LAX should load A and X");
+    assert(lax.negative_flag() && !lax.zero_flag());
+
+    CPU sax;
+    sax.load_and_run({0xA9, 0xF0, 0xA2, 0x0C, 0x85, 0x10, // LDA #$F0, LDX #$0C, STA $10
+                      0x87, 0x10});                     // *SAX $10
+    assert(sax.bus.peek(0x10) == 0x00 && "SAX should store A & X");
+    assert(!sax.zero_flag() && "SAX should leave the flags alone");
+
+    // immediate AND combos.
+    CPU anc;
+    anc.load_and_run({0xA9, 0xF0, 0x0B, 0x81}); // LDA #$F0, *ANC #$81
+    assert(anc.register_a == 0x80 && anc.negative_flag() && anc.carry_flag() && "ANC should copy N into C");
+
+    CPU alr;
+    alr.load_and_run({0xA9, 0xFF, 0x4B, 0x03}); // LDA #$FF, *ALR #$03
+    assert(alr.register_a == 0x01 && alr.carry_flag() && "ALR should AND, then LSR");
+
+    CPU arr;
+    arr.load_and_run({0x38, 0xA9, 0xFF, 0x6B, 0x80}); // SEC, LDA #$FF, *ARR #$80
+    // ($FF & $80) ROR 1 with carry in = $C0, C is bit 6, V is bit 6 ^ bit 5.
+    assert(arr.register_a == 0xC0 && arr.negative_flag() && "ARR should AND, then ROR");
+    assert(arr.carry_flag() && arr.overflow_flag() && "ARR should take C and V from bits 6 and 5");
+
+    // NOPs skip their operand bytes and take their addressing mode's cycles.
+    CPU nop;
+    nop.load({
+        0xA2, 0xFF,       // LDX #$FF
+        0x1A,             // *NOP
+        0x80, 0x00,       // *NOP #$00
+        0x04, 0x10,       // *NOP $10
+        0x14, 0x10,       // *NOP $10,X
+        0x0C, 0x00, 0x03, // *NOP $0300
+        0x1C, 0x00, 0x03, // *NOP $0300,X, same page
+        0x1C, 0x01, 0x03, // *NOP $0301,X, crosses into page $04
+    });
+    nop.reset();
+    nop.step();
+    const uint8_t widths[] = {1, 2, 2, 2, 3, 3, 3};
+    [[maybe_unused]] const uint8_t cycles[] = {2, 2, 3, 4, 4, 4, 5};
+    for (size_t i = 0; i < sizeof(widths); ++i)
+    {
+        [[maybe_unused]] uint16_t pc = nop.pc;
+        [[maybe_unused]] uint64_t before = nop.cycles;
+        [[maybe_unused]] bool stepped = nop.step();
+        assert(stepped && nop.pc == pc + widths[i] && "NOP should skip its operand");
+        assert(nop.cycles - before == cycles[i] && "NOP should take its addressing mode's cycles");
+    }
+    assert(nop.register_x == 0xFF);
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "trace_recorder.h"
+
+// Counts runs of 2 and 3 adjacent instructions in binary traces written by
+// `trace.out --binary`, to pick the fused runs in src/fusion.h. Only runs
+// that can sit inside a decoded block count: straight-line flow, with a
+// jump, branch, BRK or JAM at most as the last instruction.
+
+const size_t MAX_RUN = 3;
+
+const char *mode_name(AddressingMode mode)
+{
+    switch (mode)
+    {
+    case Immediate:
+        return "#imm";
+    case ZeroPage:
+        return "zp";
+    case ZeroPageX:
+        return "zp,X";
+    case ZeroPageY:
+        return "zp,Y";
+    case Absolute:
+        return "abs";
+    case AbsoluteX:
+        return "abs,X";
+    case AbsoluteY:
+        return "abs,Y";
+    case IndirectX:
+        return "(zp,X)";
+    case IndirectY:
+        return "(zp),Y";
+    case NoneAddressing:
+    default:
+        return "";
+    }
+}
+
+std::string describe(const std::vector<uint8_t> &codes)
+{
+    std::string hex;
+    std::string names;
+    for (uint8_t code : codes)
+    {
+        const OpCode &op = OP_CODES[code];
+        char byte[4];
+        std::snprintf(byte, sizeof(byte), "%02X ", code);
+        hex += byte;
+        names += names.empty() ? "" : " / ";
+        names += op.code_name;
+        if (op.mode != NoneAddressing)
+        {
+            names += std::string(" ") + mode_name(op.mode);
+        }
+    }
+    hex.resize(3 * MAX_RUN, ' ');
+    return hex + " " + names;
+}
+
+void print_top(const std::map<std::vector<uint8_t>, uint64_t> &counts, uint64_t total, size_t top)
+{
+    std::vector<std::pair<uint64_t, std::vector<uint8_t>>> sorted;
+    for (const auto &entry : counts)
+    {
+        sorted.emplace_back(entry.second, entry.first);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b)
+              { return a.first > b.first; });
+    for (size_t i = 0; i < sorted.size() && i < top; ++i)
+    {
+        // dispatches saved if every occurrence ran fused.
+        uint64_t saved = sorted[i].first * (sorted[i].second.size() - 1);
+        std::printf("  %6.2f%%  %10llu  %s\n", 100.0 * saved / total, static_cast<unsigned long long>(sorted[i].first),
+                    describe(sorted[i].second).c_str());
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> files;
+    size_t top = 20;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--top") == 0 && i + 1 < argc)
+        {
+            top = std::strtoul(argv[++i], nullptr, 0);
+        }
+        else
+        {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " [--top N] TRACE_FILE...\n";
+        return 1;
+    }
+
+    // runs of each length, keyed by their opcodes.
+    std::map<std::vector<uint8_t>, uint64_t> runs[MAX_RUN + 1];
+    uint64_t total = 0;
+    for (const std::string &file : files)
+    {
+        TraceReader reader(file);
+        total += reader.size();
+        for (size_t i = 0; i < reader.size(); ++i)
+        {
+            std::vector<uint8_t> codes;
+            for (size_t j = i; j < reader.size() && codes.size() < MAX_RUN; ++j)
+            {
+                const TraceRecord &record = reader[j];
+                if (!codes.empty())
+                {
+                    // the previous instruction fell through to this one.
+                    const TraceRecord &previous = reader[j - 1];
+                    const OpCode &op = OP_CODES[previous.bytes[0]];
+                    if (ends_block(op) || static_cast<uint16_t>(previous.pc + op.len) != record.pc)
+                    {
+                        break;
+                    }
+                }
+                codes.push_back(record.bytes[0]);
+                if (codes.size() >= 2)
+                {
+                    runs[codes.size()][codes]++;
+                }
+            }
+        }
+    }
+
+    std::cout << total << " instructions, share of dispatches a fused run would save:\n";
+    for (size_t length = 2; length <= MAX_RUN; ++length)
+    {
+        std::cout << "runs of " << length << ":\n";
+        print_top(runs[length], total, top);
+    }
+    return 0;
+}
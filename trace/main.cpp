@@ -1,48 +1,48 @@
 #include <iostream>
-#include <cassert>
+#include <cstring>
+#include <string>
 #include "cpu.h"
 #include "trace.h"
-#include <random>
-#include <chrono>
-#include <thread>
-#include <string>
-#include <fstream>
-#include <cassert>
+#include "trace_recorder.h"
 
 const std::string FILE_NAME = "../trace/nestest.nes";
 
-std::vector<uint8_t> read_rom(const std::string &file)
+// trace.out             text trace of nestest to stdout.
+// trace.out --binary F  fixed-size records into F, render with trace_render.out.
+int main(int argc, char *argv[])
 {
-    std::ifstream rom_file(file, std::ios::binary);
-
-    if (!rom_file)
+    std::string binary_file;
+    for (int i = 1; i < argc; i++)
     {
-        std::cerr << "Failed to open file: " << file << std::endl;
-        exit(1);
+        if (std::strcmp(argv[i], "--binary") == 0 && i + 1 < argc)
+        {
+            binary_file = argv[++i];
+        }
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--binary FILE]\n";
+            return 1;
+        }
     }
 
-    std::vector<uint8_t> rom_data((std::istreambuf_iterator<char>(rom_file)),
-                                  std::istreambuf_iterator<char>());
-
-    rom_file.close();
-
-    return rom_data;
-}
-
-int main()
-{
-    std::vector<uint8_t> rom_code = read_rom(FILE_NAME);
-
-    Rom rom(rom_code);
-    Bus bus(rom);
-    CPU cpu(bus);
+    Bus bus(Rom{FILE_NAME});
+    CPU cpu(std::move(bus));
     cpu.reset();
     cpu.pc = 0xc000;
 
-    cpu.run_with_callback([&](CPU &cpu)
-                          {
-                              std::cout << trace(cpu) << std::endl;
-                          });
+    if (!binary_file.empty())
+    {
+        TraceFile recorder(binary_file);
+        cpu.run_with([&](CPU &cpu)
+                     { recorder.push(cpu); });
+        std::cerr << "Recorded " << recorder.size() << " instructions to " << binary_file << std::endl;
+        return 0;
+    }
+
+    cpu.run_with([&](CPU &cpu)
+                 {
+                     std::cout << trace(cpu) << '\n';
+                 });
 
     return 0;
 }
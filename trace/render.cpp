@@ -0,0 +1,35 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "trace_recorder.h"
+
+// Renders a binary trace written by `trace.out --binary` as nestest.log text.
+int main(int argc, char *argv[])
+{
+    std::string file;
+    bool cycles = true;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--no-cycles") == 0)
+        {
+            cycles = false;
+        }
+        else
+        {
+            file = argv[i];
+        }
+    }
+    if (file.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " TRACE_FILE [--no-cycles]\n";
+        return 1;
+    }
+
+    TraceReader reader(file);
+    for (const TraceRecord &record : reader)
+    {
+        std::cout << format_trace(record, cycles) << '\n';
+    }
+
+    return 0;
+}
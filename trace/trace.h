@@ -1,5 +0,0 @@
-#include "cpu.h"
-#include <string>
-#include <fmt/core.h>
-#include "global.h"
-std::string trace(CPU &cpu);
\ No newline at end of file
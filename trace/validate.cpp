@@ -0,0 +1,245 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "cpu.h"
+#include "trace.h"
+#include "trace_recorder.h"
+
+// Streams the emulator trace against a golden nestest log and stops at the
+// first line that differs. Neither trace is held in memory, only the last
+// few lines of each for context.
+struct Options
+{
+    std::string rom = "../trace/nestest.nes";
+    std::string log = "../trace/nestest.log";
+    uint64_t lines = 0; // 0 compares the whole log.
+    size_t context = 8;
+    uint16_t pc = 0xc000;
+    bool cycles = true;
+    bool jit = false; // run through the JIT tier, checked at block boundaries.
+    bool fused = false; // run through the block loop with fused runs.
+};
+
+void usage(const char *name)
+{
+    std::cerr << "Usage: " << name
+              << " [--rom FILE] [--log FILE] [--lines N] [--context N] [--pc ADDR] [--no-cycles] [--jit] [--fused]\n";
+    exit(1);
+}
+
+Options parse_args(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--rom") == 0 && has_value)
+        {
+            options.rom = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--log") == 0 && has_value)
+        {
+            options.log = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--lines") == 0 && has_value)
+        {
+            options.lines = std::strtoull(argv[++i], nullptr, 0);
+        }
+        else if (std::strcmp(argv[i], "--context") == 0 && has_value)
+        {
+            options.context = std::strtoull(argv[++i], nullptr, 0);
+        }
+        else if (std::strcmp(argv[i], "--pc") == 0 && has_value)
+        {
+            options.pc = static_cast<uint16_t>(std::strtoul(argv[++i], nullptr, 0));
+        }
+        else if (std::strcmp(argv[i], "--no-cycles") == 0)
+        {
+            options.cycles = false;
+        }
+        else if (std::strcmp(argv[i], "--jit") == 0)
+        {
+            options.jit = true;
+        }
+        else if (std::strcmp(argv[i], "--fused") == 0)
+        {
+            options.fused = true;
+        }
+        else
+        {
+            usage(argv[0]);
+        }
+    }
+    return options;
+}
+
+// Names the nestest.log column a character position falls in.
+std::string field_at(const std::string &line, size_t column)
+{
+    if (column < 6)
+    {
+        return "PC";
+    }
+    if (column < 16)
+    {
+        return "opcode bytes";
+    }
+    if (column < 48)
+    {
+        return "disassembly";
+    }
+    const char *fields[] = {"A", "X", "Y", "P", "SP", "PPU", "CYC"};
+    std::string name = "registers";
+    size_t best = 0;
+    for (const char *field : fields)
+    {
+        size_t pos = line.rfind(std::string(" ") + field + ":", column);
+        if (pos != std::string::npos && pos >= best)
+        {
+            best = pos;
+            name = field;
+        }
+    }
+    return name;
+}
+
+int main(int argc, char *argv[])
+{
+    Options options = parse_args(argc, argv);
+
+    std::ifstream golden(options.log);
+    if (!golden)
+    {
+        std::cerr << "Failed to open file: " << options.log << std::endl;
+        return 1;
+    }
+
+    Bus bus(Rom{options.rom});
+    CPU cpu(std::move(bus));
+    cpu.reset();
+    cpu.pc = options.pc;
+
+    TraceRing recent(options.context + 1);
+    std::string expected;
+    uint64_t line = 0;
+    bool pending = false; // expected is read but not compared yet.
+    bool diverged = false;
+
+    auto next_line = [&]()
+    {
+        if (pending)
+        {
+            return true;
+        }
+        if ((options.lines != 0 && line == options.lines) || !std::getline(golden, expected))
+        {
+            return false;
+        }
+        if (!expected.empty() && expected.back() == '\r')
+        {
+            expected.pop_back();
+        }
+        // the log ends with a blank line.
+        if (expected.empty())
+        {
+            return false;
+        }
+        line++;
+        pending = true;
+        return true;
+    };
+
+    auto stop = [&](CPU &cpu)
+    {
+        if (!next_line())
+        {
+            return true;
+        }
+        pending = false;
+        recent.push(cpu);
+        diverged = format_trace(recent[recent.size() - 1], options.cycles) != expected;
+        return diverged;
+    };
+
+    StopReason stopped;
+    if (options.jit || options.fused)
+    {
+#ifdef NES_JIT
+        cpu.jit_enabled = options.jit;
+        cpu.jit_threshold = 1;
+#else
+        if (options.jit)
+        {
+            std::cerr << "Built without NES_JIT" << std::endl;
+            return 1;
+        }
+#endif
+        // Translated blocks and fused runs can only be checked where they
+        // start: compare that line, skip the rest of their lines. Any
+        // mismatch falls back to the interpreter, which reports it.
+        uint64_t claimed_lines = 0;
+        stopped = cpu.run_blocks_until(stop, [&](CPU &cpu, uint64_t count, uint64_t)
+                                       {
+                                           uint64_t first = pending ? line - 1 : line;
+                                           if (options.lines != 0 && first + count > options.lines)
+                                           {
+                                               return false;
+                                           }
+                                           if (!next_line() || format_trace(trace_record(cpu), options.cycles) != expected)
+                                           {
+                                               return false;
+                                           }
+                                           pending = false;
+                                           recent.push(cpu);
+                                           for (uint64_t i = 1; i < count && std::getline(golden, expected); ++i)
+                                           {
+                                               line++;
+                                           }
+                                           claimed_lines += count;
+                                           return true; });
+        std::cout << claimed_lines << " lines ran as " << (options.jit ? "native code or fused runs" : "fused runs")
+                  << std::endl;
+        if (claimed_lines == 0)
+        {
+            std::cerr << "Nothing was translated or fused" << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        stopped = cpu.run_until(stop);
+    }
+
+    if (stopped != StopReason::Budget)
+    {
+        std::cerr << "Emulator stopped (" << stop_reason_name(stopped) << ") after " << line
+                  << " lines, golden log continues:\n  " << expected << std::endl;
+        return 1;
+    }
+
+    if (!diverged)
+    {
+        std::cout << "OK: " << line << " lines match " << options.log << std::endl;
+        return 0;
+    }
+
+    std::string actual = format_trace(recent[recent.size() - 1], options.cycles);
+    size_t column = 0;
+    while (column < actual.size() && column < expected.size() && actual[column] == expected[column])
+    {
+        column++;
+    }
+
+    std::cerr << "Divergence at line " << line << ", field " << field_at(expected, column)
+              << " (column " << column + 1 << ")\n";
+    for (size_t i = 0; i + 1 < recent.size(); i++)
+    {
+        std::cerr << "    " << format_trace(recent[i], options.cycles) << '\n';
+    }
+    std::cerr << "  expected: " << expected << '\n'
+              << "  actual:   " << actual << '\n'
+              << "            " << std::string(column, ' ') << '^' << std::endl;
+    return 1;
+}